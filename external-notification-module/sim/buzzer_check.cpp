@@ -0,0 +1,200 @@
+#include "buzzer_check.h"
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "buzzer.h"
+
+/**************************typedef *******************************************/
+typedef struct _SCheckSample
+{
+  uint8_t out;
+  uint8_t relay0;
+  uint8_t relay1;
+  bool playing;
+} CheckSample;
+
+typedef struct _SCheckBeep
+{
+  uint32_t from; // first tick with the buzzer on
+  uint32_t to;   // first tick with it off again
+  BuzzerLevel level;
+} CheckBeep;
+/*****************************************************************************/
+
+/**************************global variables***********************************/
+// the pins of src/main.cpp
+static const byte check_out_pin = 8;
+static const byte check_relay_pin[2] = {6, 7};
+static const uint32_t check_forever = 0xFFFFFFFFUL;
+
+static int check_count = 0;
+static int check_failures = 0;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static CheckSample checkSample(void)
+{
+  CheckSample sample = {(uint8_t)digitalRead(check_out_pin), (uint8_t)digitalRead(check_relay_pin[0]),
+                        (uint8_t)digitalRead(check_relay_pin[1]), buzzerIsPlaying()};
+  return sample;
+}
+
+// samples[k] is the pin state once k ticks have run after buzzerPlay()
+static std::vector<CheckSample> checkPlay(BuzzerPattern pattern, BuzzerLevel level, uint32_t ticks)
+{
+  buzzerStop();
+  buzzerSetLevel(level);
+  buzzerPlay(pattern);
+
+  std::vector<CheckSample> samples;
+  samples.push_back(checkSample());
+  for (uint32_t tick = 1; tick <= ticks; tick++)
+  {
+    buzzerTick();
+    samples.push_back(checkSample());
+  }
+  return samples;
+}
+
+static bool checkRelays(const CheckSample &sample, BuzzerLevel level)
+{
+  switch (level)
+  {
+  case LEVEL1:
+    return sample.relay0 == HIGH;
+  case LEVEL2:
+    return sample.relay0 == LOW && sample.relay1 == HIGH;
+  case LEVEL3:
+    return sample.relay0 == LOW && sample.relay1 == LOW;
+  default:
+    return true;
+  }
+}
+
+// the buzzer is on exactly during beeps, with the relays set for each
+// beep's level, and the pattern plays until end_tick
+static void checkPattern(const char *name, const std::vector<CheckSample> &samples,
+                         const std::vector<CheckBeep> &beeps, uint32_t end_tick)
+{
+  check_count++;
+  for (uint32_t tick = 0; tick < samples.size(); tick++)
+  {
+    const CheckSample &sample = samples[tick];
+    const CheckBeep *beep = NULL;
+    for (size_t i = 0; i < beeps.size(); i++)
+    {
+      if (tick >= beeps[i].from && tick < beeps[i].to)
+      {
+        beep = &beeps[i];
+      }
+    }
+
+    const char *error = NULL;
+    if (sample.out != (beep != NULL ? HIGH : LOW))
+    {
+      error = (beep != NULL) ? "buzzer off, expected on" : "buzzer on, expected off";
+    }
+    else if (beep != NULL && !checkRelays(sample, beep->level))
+    {
+      error = "relays do not select the step's level";
+    }
+    else if (sample.playing != (tick < end_tick))
+    {
+      error = sample.playing ? "still playing" : "stopped early";
+    }
+
+    if (error != NULL)
+    {
+      printf("FAIL %s, tick %u: %s\n", name, tick, error);
+      check_failures++;
+      return;
+    }
+  }
+}
+
+static void checkSilent(const char *name, const std::vector<CheckSample> &samples)
+{
+  check_count++;
+  for (uint32_t tick = 0; tick < samples.size(); tick++)
+  {
+    if (samples[tick].out != LOW)
+    {
+      printf("FAIL %s, tick %u: buzzer on while muted\n", name, tick);
+      check_failures++;
+      return;
+    }
+  }
+}
+
+int buzzerCheckAll(void)
+{
+  buzzerInit(check_out_pin, check_relay_pin[0], check_relay_pin[1]);
+  std::vector<CheckBeep> beeps;
+
+  // one-shot: three 150 ms beeps 150 ms apart at the chosen level, then off
+  beeps = {{0, 15, LEVEL2}, {30, 45, LEVEL2}, {60, 75, LEVEL2}};
+  checkPattern("BUZZER_TRIPLE", checkPlay(BUZZER_TRIPLE, LEVEL2, 200), beeps, 90);
+
+  beeps = {{0, 100, LEVEL3}};
+  checkPattern("BUZZER_BEEP", checkPlay(BUZZER_BEEP, LEVEL3, 200), beeps, 100);
+
+  // steady runs across the 255-tick step boundary without a gap
+  beeps = {{0, 1000, LEVEL1}};
+  checkPattern("BUZZER_STEADY", checkPlay(BUZZER_STEADY, LEVEL1, 999), beeps, check_forever);
+
+  beeps = {{0, 10, LEVEL1}, {200, 210, LEVEL1}, {400, 410, LEVEL1}};
+  checkPattern("BUZZER_REMINDER", checkPlay(BUZZER_REMINDER, LEVEL1, 500), beeps, check_forever);
+
+  // fixed levels whatever the chosen one, a silent LEVEL0 pause, then again
+  beeps = {{0, 20, LEVEL1}, {50, 70, LEVEL1}, {100, 120, LEVEL1},
+           {150, 170, LEVEL2}, {190, 210, LEVEL2}, {230, 250, LEVEL2},
+           {270, 300, LEVEL3}, {310, 340, LEVEL3}, {350, 380, LEVEL3}, {390, 420, LEVEL3}, {430, 460, LEVEL3},
+           {671, 691, LEVEL1}};
+  checkPattern("BUZZER_ESCALATE", checkPlay(BUZZER_ESCALATE, LEVEL2, 700), beeps, check_forever);
+
+  checkSilent("BUZZER_STEADY at LEVEL0", checkPlay(BUZZER_STEADY, LEVEL0, 300));
+  checkSilent("BUZZER_BEEP at LEVEL0", checkPlay(BUZZER_BEEP, LEVEL0, 300));
+  checkSilent("BUZZER_TRIPLE at LEVEL0", checkPlay(BUZZER_TRIPLE, LEVEL0, 300));
+  checkSilent("BUZZER_ESCALATE at LEVEL0", checkPlay(BUZZER_ESCALATE, LEVEL0, 700));
+  checkSilent("BUZZER_REMINDER at LEVEL0", checkPlay(BUZZER_REMINDER, LEVEL0, 500));
+
+  // a held beep needs no timer, so loop() may sleep in standby under it;
+  // a timed pattern holds Timer1 until its last tick
+  check_count++;
+  checkPlay(BUZZER_STEADY, LEVEL1, 0);
+  if (buzzerIsTimed() || !buzzerIsPlaying())
+  {
+    printf("FAIL BUZZER_STEADY: runs Timer1\n");
+    check_failures++;
+  }
+  check_count++;
+  checkPlay(BUZZER_TRIPLE, LEVEL1, 89);
+  bool was_timed = buzzerIsTimed();
+  buzzerTick();
+  if (!was_timed || buzzerIsTimed())
+  {
+    printf("FAIL BUZZER_TRIPLE: Timer1 not held until the end\n");
+    check_failures++;
+  }
+
+  // buzzerStop() in the middle of a beep silences it, later ticks do nothing
+  check_count++;
+  checkPlay(BUZZER_ESCALATE, LEVEL1, 5);
+  buzzerStop();
+  for (int tick = 0; tick < 300; tick++)
+  {
+    buzzerTick();
+  }
+  if (digitalRead(check_out_pin) != LOW || buzzerIsPlaying())
+  {
+    printf("FAIL buzzerStop(): still sounding\n");
+    check_failures++;
+  }
+
+  buzzerSetLevel(LEVEL1);
+  printf("buzzer: %d/%d checks passed\n", check_count - check_failures, check_count);
+  return check_failures;
+}
+/*****************************************************************************/
@@ -0,0 +1,12 @@
+#ifndef BUZZER_CHECK_H
+#define BUZZER_CHECK_H
+
+/**************************Buzzer pattern checks******************************/
+// Plays each pattern of src/buzzer.cpp with buzzerTick() driven directly,
+// tick by tick, and checks the buzzer and relay pins against the timing the
+// pattern tables promise. Must run before simSetTimer() registers the tick.
+// Returns the number of failed checks.
+int buzzerCheckAll(void);
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,174 @@
+#include "Arduino.h"
+
+/**************************global variables***********************************/
+SimPin sim_pins[SIM_PINS];
+HardwareSerial Serial;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+// Timer0 time, frozen in standby like on the Uno
+unsigned long millis(void)
+{
+  return (unsigned long)(simTimer0Us() / 1000);
+}
+
+unsigned long micros(void)
+{
+  return (unsigned long)simTimer0Us();
+}
+
+void delay(unsigned long ms)
+{
+  simAdvance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  simAdvance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (pin < SIM_PINS)
+  {
+    sim_pins[pin].mode = mode;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level)
+{
+  simAdvance(SIM_DIGITAL_WRITE_US);
+  sim_counters.digital_writes++;
+  if (pin >= SIM_PINS)
+  {
+    return;
+  }
+
+  SimPin *sim_pin = &sim_pins[pin];
+  uint64_t now = simMicros();
+  if (sim_pin->level == HIGH)
+  {
+    sim_pin->high_us += now - sim_pin->last_change_us;
+  }
+  sim_pin->last_change_us = now;
+  sim_pin->level = level ? HIGH : LOW;
+  sim_pin->writes++;
+}
+
+int digitalRead(uint8_t pin)
+{
+  return (pin < SIM_PINS) ? sim_pins[pin].level : LOW;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t written = 0;
+  while (size--)
+  {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+size_t Print::print(long value, int base)
+{
+  char str[24];
+  snprintf(str, sizeof(str), (base == HEX) ? "%lX" : "%ld", value);
+  return write(str);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+  char str[24];
+  snprintf(str, sizeof(str), (base == HEX) ? "%lX" : "%lu", value);
+  return write(str);
+}
+
+size_t Print::print(double value, int digits)
+{
+  char str[32];
+  snprintf(str, sizeof(str), "%.*f", digits, value);
+  return write(str);
+}
+
+int Stream::timedRead(void)
+{
+  uint64_t deadline = simMicros() + (uint64_t)timeout_ms * 1000;
+  do
+  {
+    int c = read();
+    if (c >= 0)
+    {
+      return c;
+    }
+  } while (simWaitForInput(deadline));
+  return -1;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+  std::string str;
+  int c = timedRead();
+  while (c >= 0 && c != terminator)
+  {
+    str += (char)c;
+    c = timedRead();
+  }
+  return String(str);
+}
+
+String Stream::readString(void)
+{
+  std::string str;
+  int c = timedRead();
+  while (c >= 0)
+  {
+    str += (char)c;
+    c = timedRead();
+  }
+  return String(str);
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+  byte_us = (uint32_t)(10000000UL / baud);
+  drained_at_us = simMicros();
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+  uint64_t now = simMicros();
+  if (drained_at_us <= now)
+  {
+    return SIM_UART_TX_BUFFER;
+  }
+  uint64_t queued = (drained_at_us - now + byte_us - 1) / byte_us;
+  return (queued >= SIM_UART_TX_BUFFER) ? 0 : SIM_UART_TX_BUFFER - (int)queued;
+}
+
+void HardwareSerial::flush(void)
+{
+  simAdvanceTo(drained_at_us);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  // a full TX buffer makes the real write() spin until a byte has left
+  if (availableForWrite() == 0)
+  {
+    uint64_t before = simMicros();
+    simAdvanceTo(drained_at_us - (uint64_t)(SIM_UART_TX_BUFFER - 1) * byte_us);
+    sim_counters.serial_block_us += simMicros() - before;
+  }
+
+  uint64_t now = simMicros();
+  drained_at_us = ((drained_at_us > now) ? drained_at_us : now) + byte_us;
+  sim_counters.serial_tx_bytes++;
+  output += (char)c;
+  if (echo)
+  {
+    fputc(c, stdout);
+  }
+  return 1;
+}
+/*****************************************************************************/
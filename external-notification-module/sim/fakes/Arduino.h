@@ -0,0 +1,132 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "WString.h"
+#include "sim_clock.h"
+
+/**************************Arduino core (host)********************************/
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define PSTR(str) (str)
+#define F(str) (str)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void *const *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+void setup(void);
+void loop(void);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+// pin state as seen by the simulation
+#define SIM_PINS 20
+typedef struct _SSimPin
+{
+  uint8_t mode;
+  uint8_t level;
+  uint32_t writes;
+  uint64_t high_us;      // total time spent HIGH, up to last_change_us
+  uint64_t last_change_us;
+} SimPin;
+extern SimPin sim_pins[SIM_PINS];
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+  virtual int availableForWrite(void) { return 0; }
+  virtual void flush(void) {}
+
+  size_t print(const char *str) { return write(str); }
+  size_t print(const String &str) { return write(str.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println(void) { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(const T &value, int format) { return print(value, format) + println(); }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+
+  void setTimeout(unsigned long timeout) { timeout_ms = timeout; }
+  String readStringUntil(char terminator);
+  String readString(void);
+
+protected:
+  int timedRead(void); // waits on the virtual clock, -1 on timeout
+  unsigned long timeout_ms = 1000;
+};
+
+// TX side of the Uno UART: a 64 byte buffer drained at the configured baud
+class HardwareSerial : public Stream
+{
+public:
+  void begin(unsigned long baud);
+  void end(void) {}
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+  int peek(void) { return -1; }
+  int availableForWrite(void);
+  void flush(void);
+  size_t write(uint8_t c);
+  using Print::write;
+  operator bool() const { return true; }
+
+  std::string output; // everything written, for the report
+  bool echo = false;  // copy output to stdout as it is written
+
+private:
+  uint32_t byte_us = SIM_UART_BYTE_US;
+  uint64_t drained_at_us = 0; // when the last queued byte leaves the wire
+};
+
+extern HardwareSerial Serial;
+/*****************************************************************************/
+
+#endif
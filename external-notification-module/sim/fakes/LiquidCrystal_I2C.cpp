@@ -0,0 +1,115 @@
+#include "LiquidCrystal_I2C.h"
+
+/**************************global variables***********************************/
+LiquidCrystal_I2C *sim_lcd = NULL;
+
+static const uint8_t lcd_row_offset[4] = {0x00, 0x40, 0x14, 0x54};
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows)
+    : lcd_cols(cols), lcd_rows(rows)
+{
+  (void)addr;
+  memset(ddram, ' ', sizeof(ddram));
+  sim_lcd = this;
+}
+
+// one expander write: address byte plus data byte
+void LiquidCrystal_I2C::expanderWrite(void)
+{
+  sim_counters.i2c_bytes += 2;
+  simAdvance(2 * SIM_I2C_BYTE_US);
+}
+
+// one byte to the controller: two nibbles, each data + enable high + low
+void LiquidCrystal_I2C::command(void)
+{
+  for (int nibble = 0; nibble < 2; nibble++)
+  {
+    expanderWrite();
+    expanderWrite();
+    expanderWrite();
+    simAdvance(SIM_LCD_PULSE_US);
+  }
+  sim_counters.lcd_writes++;
+}
+
+void LiquidCrystal_I2C::init(void)
+{
+  // the library waits 50 ms for power-up and 1 s after the first write
+  delay(50);
+  expanderWrite();
+  delay(1000);
+  for (int i = 0; i < 8; i++) // reset sequence, function set, mode, clear
+  {
+    command();
+  }
+  delay(2);
+  memset(ddram, ' ', sizeof(ddram));
+  ddram_addr = 0;
+}
+
+void LiquidCrystal_I2C::clear(void)
+{
+  command();
+  simAdvance(SIM_LCD_CLEAR_US);
+  memset(ddram, ' ', sizeof(ddram));
+  ddram_addr = 0;
+}
+
+void LiquidCrystal_I2C::home(void)
+{
+  command();
+  simAdvance(SIM_LCD_CLEAR_US);
+  ddram_addr = 0;
+}
+
+void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row)
+{
+  if (row >= lcd_rows)
+  {
+    row = lcd_rows - 1;
+  }
+  command();
+  ddram_addr = (lcd_row_offset[row] + col) & 0x7F;
+}
+
+void LiquidCrystal_I2C::backlight(void)
+{
+  lcd_backlight = true;
+  expanderWrite();
+}
+
+void LiquidCrystal_I2C::noBacklight(void)
+{
+  lcd_backlight = false;
+  expanderWrite();
+}
+
+size_t LiquidCrystal_I2C::write(uint8_t c)
+{
+  command();
+  ddram[ddram_addr] = (char)c;
+  // the address counter runs 0x00..0x27 then 0x40..0x67 and wraps
+  ddram_addr++;
+  if (ddram_addr == 0x28)
+  {
+    ddram_addr = 0x40;
+  }
+  else if (ddram_addr == 0x68)
+  {
+    ddram_addr = 0x00;
+  }
+  return 1;
+}
+
+std::string LiquidCrystal_I2C::row(uint8_t row) const
+{
+  if (row >= 4)
+  {
+    return std::string();
+  }
+  return std::string(&ddram[lcd_row_offset[row]], lcd_cols);
+}
+/*****************************************************************************/
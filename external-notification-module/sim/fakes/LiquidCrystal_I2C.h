@@ -0,0 +1,51 @@
+#ifndef LIQUID_CRYSTAL_I2C_H
+#define LIQUID_CRYSTAL_I2C_H
+
+#include <Arduino.h>
+
+/**************************LiquidCrystal_I2C (host)***************************/
+// HD44780 behind a PCF8574 expander. Keeps the controller's 128 byte DDRAM
+// with its real row layout, so text that runs past column 19 of row 0/1
+// shows up in row 2/3 exactly as on the module. Every character or command
+// costs two nibbles of three expander writes, 12 bytes on the I2C wire.
+class LiquidCrystal_I2C : public Print
+{
+public:
+  LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows);
+  void init(void);
+  void begin(uint8_t cols, uint8_t rows)
+  {
+    (void)cols;
+    (void)rows;
+    init();
+  }
+  void clear(void);
+  void home(void);
+  void setCursor(uint8_t col, uint8_t row);
+  void backlight(void);
+  void noBacklight(void);
+  void display(void) { command(); }
+  void noDisplay(void) { command(); }
+  size_t write(uint8_t c);
+  using Print::write;
+
+  // text of one row as currently shown, for the simulation report
+  std::string row(uint8_t row) const;
+  uint8_t cols(void) const { return lcd_cols; }
+  uint8_t rows(void) const { return lcd_rows; }
+  bool isBacklit(void) const { return lcd_backlight; }
+
+private:
+  void command(void);
+  void expanderWrite(void);
+
+  uint8_t lcd_cols, lcd_rows;
+  uint8_t ddram_addr = 0;
+  bool lcd_backlight = false;
+  char ddram[128];
+};
+
+extern LiquidCrystal_I2C *sim_lcd; // the instance the firmware created
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,22 @@
+#include "RtcDS1302.h"
+
+/**************************global variables***********************************/
+SimRtc sim_rtc = {0, 0, false, true};
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+void simRtcSet(uint32_t seconds_from_2000)
+{
+  sim_rtc.seconds = seconds_from_2000;
+  sim_rtc.set_us = simMicros();
+}
+
+uint32_t simRtcNow(void)
+{
+  if (!sim_rtc.running)
+  {
+    return sim_rtc.seconds;
+  }
+  return sim_rtc.seconds + (uint32_t)((simMicros() - sim_rtc.set_us) / 1000000);
+}
+/*****************************************************************************/
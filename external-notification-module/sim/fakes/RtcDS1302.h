@@ -0,0 +1,83 @@
+#ifndef RTC_DS1302_H
+#define RTC_DS1302_H
+
+#include <Arduino.h>
+#include <RtcDateTime.h>
+
+/**************************RtcDS1302 (host)***********************************/
+// The DS1302 counts from the time the simulation set with simRtcSet(),
+// following the virtual clock. Register traffic is charged to the wire:
+// a command byte plus one data byte, or plus 8 for the clock burst.
+typedef struct _SSimRtc
+{
+  uint32_t seconds;    // RtcDateTime seconds at set_us
+  uint64_t set_us;
+  bool write_protected;
+  bool running;
+} SimRtc;
+
+extern SimRtc sim_rtc;
+
+void simRtcSet(uint32_t seconds_from_2000);
+uint32_t simRtcNow(void);
+
+template <class T>
+class RtcDS1302
+{
+public:
+  RtcDS1302(T &wire) : rtc_wire(wire) {}
+
+  void Begin(void) { rtc_wire.begin(); }
+
+  bool GetIsWriteProtected(void)
+  {
+    rtc_wire.transfer(2);
+    return sim_rtc.write_protected;
+  }
+
+  void SetIsWriteProtected(bool is_write_protected)
+  {
+    rtc_wire.transfer(2);
+    sim_rtc.write_protected = is_write_protected;
+  }
+
+  bool GetIsRunning(void)
+  {
+    rtc_wire.transfer(2);
+    return sim_rtc.running;
+  }
+
+  void SetIsRunning(bool is_running)
+  {
+    rtc_wire.transfer(2);
+    if (is_running != sim_rtc.running)
+    {
+      // a halted clock resumes where it stopped
+      sim_rtc.seconds = simRtcNow();
+      sim_rtc.set_us = simMicros();
+    }
+    sim_rtc.running = is_running;
+  }
+
+  RtcDateTime GetDateTime(void)
+  {
+    rtc_wire.transfer(9);
+    sim_counters.rtc_reads++;
+    return RtcDateTime(simRtcNow());
+  }
+
+  void SetDateTime(const RtcDateTime &date_time)
+  {
+    rtc_wire.transfer(9);
+    if (!sim_rtc.write_protected)
+    {
+      simRtcSet(date_time.TotalSeconds());
+    }
+  }
+
+private:
+  T &rtc_wire;
+};
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,97 @@
+#include "RtcDateTime.h"
+
+/**************************global variables***********************************/
+static const uint8_t rtc_days_in_month[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static bool rtcIsLeap(uint16_t year)
+{
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static uint8_t rtcDaysInMonth(uint16_t year, uint8_t month)
+{
+  return (month == 2 && rtcIsLeap(year)) ? 29 : rtc_days_in_month[month - 1];
+}
+
+RtcDateTime::RtcDateTime(uint32_t seconds_from_2000)
+{
+  initWithSecondsFrom2000(seconds_from_2000);
+}
+
+RtcDateTime::RtcDateTime(uint16_t year, uint8_t month, uint8_t day,
+                         uint8_t hour, uint8_t minute, uint8_t second)
+    : rtc_year(year), rtc_month(month), rtc_day(day),
+      rtc_hour(hour), rtc_minute(minute), rtc_second(second)
+{
+}
+
+RtcDateTime::RtcDateTime(const char *date, const char *time)
+{
+  // "Aug 21 2021", "08:15:00"
+  static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  rtc_month = 1;
+  for (uint8_t i = 0; i < 12; i++)
+  {
+    if (strncmp(date, &months[i * 3], 3) == 0)
+    {
+      rtc_month = i + 1;
+      break;
+    }
+  }
+  rtc_day = (uint8_t)atoi(date + 4);
+  rtc_year = (uint16_t)atoi(date + 7);
+  rtc_hour = (uint8_t)atoi(time);
+  rtc_minute = (uint8_t)atoi(time + 3);
+  rtc_second = (uint8_t)atoi(time + 6);
+}
+
+void RtcDateTime::initWithSecondsFrom2000(uint32_t seconds)
+{
+  rtc_second = seconds % 60;
+  seconds /= 60;
+  rtc_minute = seconds % 60;
+  seconds /= 60;
+  rtc_hour = seconds % 24;
+  uint32_t days = seconds / 24;
+
+  rtc_year = 2000;
+  while (days >= (rtcIsLeap(rtc_year) ? 366u : 365u))
+  {
+    days -= rtcIsLeap(rtc_year) ? 366 : 365;
+    rtc_year++;
+  }
+  rtc_month = 1;
+  while (days >= rtcDaysInMonth(rtc_year, rtc_month))
+  {
+    days -= rtcDaysInMonth(rtc_year, rtc_month);
+    rtc_month++;
+  }
+  rtc_day = (uint8_t)days + 1;
+}
+
+uint16_t RtcDateTime::TotalDays(void) const
+{
+  uint16_t days = rtc_day - 1;
+  for (uint8_t month = 1; month < rtc_month; month++)
+  {
+    days += rtcDaysInMonth(rtc_year, month);
+  }
+  for (uint16_t year = 2000; year < rtc_year; year++)
+  {
+    days += rtcIsLeap(year) ? 366 : 365;
+  }
+  return days;
+}
+
+uint32_t RtcDateTime::TotalSeconds(void) const
+{
+  return ((uint32_t)TotalDays() * 24 + rtc_hour) * 3600 + (uint32_t)rtc_minute * 60 + rtc_second;
+}
+
+uint8_t RtcDateTime::DayOfWeek(void) const
+{
+  return (TotalDays() + 6) % 7; // 2000-01-01 was a Saturday
+}
+/*****************************************************************************/
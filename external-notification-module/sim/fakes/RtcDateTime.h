@@ -0,0 +1,43 @@
+#ifndef RTC_DATE_TIME_H
+#define RTC_DATE_TIME_H
+
+#include <Arduino.h>
+
+/**************************RtcDateTime (host)*********************************/
+// Same epoch and accessors as the Makuna RTC library: seconds since
+// 2000-01-01 00:00:00, valid through 2099.
+class RtcDateTime
+{
+public:
+  RtcDateTime(uint32_t seconds_from_2000 = 0);
+  RtcDateTime(uint16_t year, uint8_t month, uint8_t day,
+              uint8_t hour, uint8_t minute, uint8_t second);
+  RtcDateTime(const char *date, const char *time); // __DATE__, __TIME__
+
+  bool IsValid(void) const { return rtc_month >= 1 && rtc_month <= 12 && rtc_day >= 1; }
+  uint16_t Year(void) const { return rtc_year; }
+  uint8_t Month(void) const { return rtc_month; }
+  uint8_t Day(void) const { return rtc_day; }
+  uint8_t Hour(void) const { return rtc_hour; }
+  uint8_t Minute(void) const { return rtc_minute; }
+  uint8_t Second(void) const { return rtc_second; }
+  uint8_t DayOfWeek(void) const; // 0 = Sunday
+  uint32_t TotalSeconds(void) const;
+  uint16_t TotalDays(void) const;
+
+  bool operator==(const RtcDateTime &other) const { return TotalSeconds() == other.TotalSeconds(); }
+  bool operator!=(const RtcDateTime &other) const { return TotalSeconds() != other.TotalSeconds(); }
+  bool operator<(const RtcDateTime &other) const { return TotalSeconds() < other.TotalSeconds(); }
+  bool operator>(const RtcDateTime &other) const { return TotalSeconds() > other.TotalSeconds(); }
+  bool operator<=(const RtcDateTime &other) const { return TotalSeconds() <= other.TotalSeconds(); }
+  bool operator>=(const RtcDateTime &other) const { return TotalSeconds() >= other.TotalSeconds(); }
+
+private:
+  void initWithSecondsFrom2000(uint32_t seconds);
+
+  uint16_t rtc_year;
+  uint8_t rtc_month, rtc_day, rtc_hour, rtc_minute, rtc_second;
+};
+/*****************************************************************************/
+
+#endif
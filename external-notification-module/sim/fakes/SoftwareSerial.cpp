@@ -0,0 +1,119 @@
+#include "SoftwareSerial.h"
+
+/**************************global variables***********************************/
+std::string sim_bt_tx;
+
+static std::deque<SimBtByte> sim_bt_air; // scheduled, not yet arrived
+static std::deque<char> sim_bt_rx;       // arrived, not yet read
+static uint32_t sim_bt_byte_us = SIM_UART_BYTE_US;
+static uint32_t sim_bt_read = 0;
+static uint32_t sim_bt_overflows = 0;
+static bool sim_bt_overflow_flag = false;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+// moves everything that has arrived by now into the receive buffer
+static void simBtReceive(void)
+{
+  uint64_t now = simMicros();
+  while (!sim_bt_air.empty() && sim_bt_air.front().at_us <= now)
+  {
+    if (sim_bt_rx.size() < SIM_SS_RX_BUFFER)
+    {
+      sim_bt_rx.push_back(sim_bt_air.front().c);
+    }
+    else
+    {
+      sim_bt_overflows++;
+      sim_bt_overflow_flag = true;
+    }
+    sim_bt_air.pop_front();
+  }
+}
+
+uint64_t simBtSchedule(uint64_t at_us, const char *line)
+{
+  if (!sim_bt_air.empty() && sim_bt_air.back().at_us >= at_us)
+  {
+    at_us = sim_bt_air.back().at_us + sim_bt_byte_us; // the link is busy
+  }
+
+  for (const char *c = line; *c != '\0'; c++)
+  {
+    at_us += sim_bt_byte_us;
+    SimBtByte byte = {at_us, *c};
+    sim_bt_air.push_back(byte);
+  }
+  return at_us;
+}
+
+uint64_t simBtNextByteUs(void)
+{
+  return sim_bt_air.empty() ? UINT64_MAX : sim_bt_air.front().at_us;
+}
+
+uint32_t simBtBytesRead(void)
+{
+  return sim_bt_read;
+}
+
+uint32_t simBtOverflows(void)
+{
+  return sim_bt_overflows;
+}
+
+SoftwareSerial::SoftwareSerial(uint8_t rx_pin, uint8_t tx_pin, bool inverse_logic)
+{
+  (void)rx_pin;
+  (void)tx_pin;
+  (void)inverse_logic;
+  simSetInputSource(simBtNextByteUs);
+}
+
+void SoftwareSerial::begin(long baud)
+{
+  sim_bt_byte_us = (uint32_t)(10000000L / baud);
+}
+
+bool SoftwareSerial::overflow(void)
+{
+  simBtReceive();
+  bool flag = sim_bt_overflow_flag;
+  sim_bt_overflow_flag = false;
+  return flag;
+}
+
+int SoftwareSerial::available(void)
+{
+  simBtReceive();
+  return (int)sim_bt_rx.size();
+}
+
+int SoftwareSerial::read(void)
+{
+  simBtReceive();
+  if (sim_bt_rx.empty())
+  {
+    return -1;
+  }
+  char c = sim_bt_rx.front();
+  sim_bt_rx.pop_front();
+  sim_bt_read++;
+  sim_counters.bt_rx_bytes++;
+  return (uint8_t)c;
+}
+
+int SoftwareSerial::peek(void)
+{
+  simBtReceive();
+  return sim_bt_rx.empty() ? -1 : (uint8_t)sim_bt_rx.front();
+}
+
+size_t SoftwareSerial::write(uint8_t c)
+{
+  // transmitting is bit-banged with interrupts off, the CPU is busy throughout
+  simAdvance(sim_bt_byte_us);
+  sim_bt_tx += (char)c;
+  return 1;
+}
+/*****************************************************************************/
@@ -0,0 +1,46 @@
+#ifndef SOFTWARE_SERIAL_H
+#define SOFTWARE_SERIAL_H
+
+#include <Arduino.h>
+
+#include <deque>
+
+/**************************SoftwareSerial (host)******************************/
+// The Bluetooth module side. The simulation schedules lines with
+// simBtSchedule(); their bytes arrive back to back at the configured baud
+// and land in a 63 byte receive buffer like the real library's, bytes that
+// arrive while it is full are counted as overflow and lost.
+#define SIM_SS_RX_BUFFER 63
+
+class SoftwareSerial : public Stream
+{
+public:
+  SoftwareSerial(uint8_t rx_pin, uint8_t tx_pin, bool inverse_logic = false);
+  void begin(long baud);
+  bool listen(void) { return true; }
+  bool isListening(void) { return true; }
+  bool overflow(void);
+  int available(void);
+  int read(void);
+  int peek(void);
+  size_t write(uint8_t c);
+  using Print::write;
+  operator bool() const { return true; }
+};
+
+typedef struct _SSimBtByte
+{
+  uint64_t at_us;
+  char c;
+} SimBtByte;
+
+// queues a line for reception starting at at_us, returns the time its
+// last byte arrives
+uint64_t simBtSchedule(uint64_t at_us, const char *line);
+uint64_t simBtNextByteUs(void); // UINT64_MAX when nothing is pending
+uint32_t simBtBytesRead(void);
+uint32_t simBtOverflows(void);
+extern std::string sim_bt_tx; // what the firmware sent to the phone
+/*****************************************************************************/
+
+#endif
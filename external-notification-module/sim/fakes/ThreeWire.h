@@ -0,0 +1,28 @@
+#ifndef THREE_WIRE_H
+#define THREE_WIRE_H
+
+#include <Arduino.h>
+
+/**************************ThreeWire (host)***********************************/
+// Only charges bus time, the DS1302 fake keeps the clock itself.
+class ThreeWire
+{
+public:
+  ThreeWire(uint8_t io_pin, uint8_t clk_pin, uint8_t ce_pin)
+  {
+    (void)io_pin;
+    (void)clk_pin;
+    (void)ce_pin;
+  }
+  void begin(void) {}
+  void end(void) {}
+
+  void transfer(uint8_t bytes)
+  {
+    sim_counters.rtc_bytes += bytes;
+    simAdvance((uint64_t)bytes * SIM_RTC_BYTE_US);
+  }
+};
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,161 @@
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+/***************user-defined functions****************************************/
+String::String(const char *str) : buffer(str ? str : "") {}
+String::String(const std::string &str) : buffer(str) {}
+String::String(char c) : buffer(1, c) {}
+String::String(int value) : buffer(std::to_string(value)) {}
+String::String(unsigned int value) : buffer(std::to_string(value)) {}
+String::String(long value) : buffer(std::to_string(value)) {}
+String::String(unsigned long value) : buffer(std::to_string(value)) {}
+
+char String::charAt(unsigned int idx) const
+{
+  return (idx < buffer.length()) ? buffer[idx] : '\0';
+}
+
+bool String::concat(const String &str)
+{
+  buffer += str.buffer;
+  return true;
+}
+
+bool String::concat(const char *str)
+{
+  if (str == NULL)
+  {
+    return false;
+  }
+  buffer += str;
+  return true;
+}
+
+bool String::concat(char c)
+{
+  buffer += c;
+  return true;
+}
+
+bool String::concat(int value) { return concat(String(value)); }
+bool String::concat(unsigned int value) { return concat(String(value)); }
+bool String::concat(long value) { return concat(String(value)); }
+bool String::concat(unsigned long value) { return concat(String(value)); }
+
+String &String::operator+=(const String &str)
+{
+  concat(str);
+  return *this;
+}
+
+String &String::operator+=(const char *str)
+{
+  concat(str);
+  return *this;
+}
+
+String &String::operator+=(char c)
+{
+  concat(c);
+  return *this;
+}
+
+int String::indexOf(char c) const
+{
+  return indexOf(c, 0);
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+  if (from >= buffer.length())
+  {
+    return -1;
+  }
+  std::string::size_type idx = buffer.find(c, from);
+  return (idx == std::string::npos) ? -1 : (int)idx;
+}
+
+String String::substring(unsigned int from) const
+{
+  return substring(from, length());
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+  if (from > to)
+  {
+    unsigned int tmp = from;
+    from = to;
+    to = tmp;
+  }
+  if (from >= length())
+  {
+    return String();
+  }
+  if (to > length())
+  {
+    to = length();
+  }
+  return String(buffer.substr(from, to - from));
+}
+
+void String::replace(char find, char replace)
+{
+  for (std::string::size_type i = 0; i < buffer.length(); i++)
+  {
+    if (buffer[i] == find)
+    {
+      buffer[i] = replace;
+    }
+  }
+}
+
+void String::remove(unsigned int idx)
+{
+  remove(idx, (unsigned int)-1);
+}
+
+void String::remove(unsigned int idx, unsigned int count)
+{
+  if (idx < buffer.length())
+  {
+    buffer.erase(idx, count);
+  }
+}
+
+void String::trim(void)
+{
+  std::string::size_type begin = 0, end = buffer.length();
+  while (begin < end && isspace((unsigned char)buffer[begin]))
+  {
+    begin++;
+  }
+  while (end > begin && isspace((unsigned char)buffer[end - 1]))
+  {
+    end--;
+  }
+  buffer = buffer.substr(begin, end - begin);
+}
+
+long String::toInt(void) const
+{
+  return atol(buffer.c_str());
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+  return String(lhs.buffer + rhs.buffer);
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+  return String(lhs.buffer + rhs);
+}
+
+String operator+(const char *lhs, const String &rhs)
+{
+  return String(lhs + rhs.buffer);
+}
+/*****************************************************************************/
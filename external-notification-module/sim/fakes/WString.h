@@ -0,0 +1,62 @@
+#ifndef WSTRING_H
+#define WSTRING_H
+
+#include <string>
+
+/**************************Arduino String (host)******************************/
+// The subset of the Arduino String API the firmware uses, same semantics
+// for out-of-range indices (clamped) and for indexOf() misses (-1).
+class String
+{
+public:
+  String(const char *str = "");
+  String(const std::string &str);
+  explicit String(char c);
+  explicit String(int value);
+  explicit String(unsigned int value);
+  explicit String(long value);
+  explicit String(unsigned long value);
+
+  unsigned int length(void) const { return (unsigned int)buffer.length(); }
+  const char *c_str(void) const { return buffer.c_str(); }
+  char charAt(unsigned int idx) const;
+  char operator[](unsigned int idx) const { return charAt(idx); }
+
+  bool concat(const String &str);
+  bool concat(const char *str);
+  bool concat(char c);
+  bool concat(int value);
+  bool concat(unsigned int value);
+  bool concat(long value);
+  bool concat(unsigned long value);
+  String &operator+=(const String &str);
+  String &operator+=(const char *str);
+  String &operator+=(char c);
+
+  bool equals(const String &str) const { return buffer == str.buffer; }
+  bool equals(const char *str) const { return buffer == str; }
+  bool operator==(const String &str) const { return equals(str); }
+  bool operator==(const char *str) const { return equals(str); }
+  bool operator!=(const String &str) const { return !equals(str); }
+
+  int indexOf(char c) const;
+  int indexOf(char c, unsigned int from) const;
+  String substring(unsigned int from) const;
+  String substring(unsigned int from, unsigned int to) const;
+  void replace(char find, char replace);
+  void remove(unsigned int idx);
+  void remove(unsigned int idx, unsigned int count);
+  void trim(void);
+  void clear(void) { buffer.clear(); }
+  long toInt(void) const;
+
+  friend String operator+(const String &lhs, const String &rhs);
+  friend String operator+(const String &lhs, const char *rhs);
+  friend String operator+(const char *lhs, const String &rhs);
+
+private:
+  std::string buffer;
+};
+/*****************************************************************************/
+
+#endif
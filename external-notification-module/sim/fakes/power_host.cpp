@@ -0,0 +1,38 @@
+#include <Arduino.h>
+
+#include "power.h"
+
+/**************************Sleep model (host)*********************************/
+// powerSleepCpu() of src/power.cpp for the simulation, built with POWER_SIM.
+// The CPU sleeps on the virtual clock until the next interrupt. In standby
+// only the watchdog (powerTick) and the Bluetooth pin change wake it, and
+// Timer0 stops, so millis() stands still; in idle every timer keeps running.
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+void powerSleepCpu(bool keep_timers)
+{
+  // a draining UART wakes the CPU once per byte, like the UDRE interrupt
+  bool uart_busy = Serial.availableForWrite() < SIM_UART_TX_BUFFER;
+  bool standby = !keep_timers && !uart_busy;
+  uint64_t now = simMicros();
+  uint64_t deadline = simTimerNextUs(standby ? powerTick : 0);
+  if (uart_busy && now + SIM_UART_BYTE_US < deadline)
+  {
+    deadline = now + SIM_UART_BYTE_US;
+  }
+
+  if (standby)
+  {
+    simStandbyBegin();
+    simWaitForInput(deadline);
+    simStandbyEnd();
+  }
+  else
+  {
+    simWaitForInput(deadline);
+    sim_counters.idle_us += simMicros() - now;
+  }
+  interrupts();
+}
+/*****************************************************************************/
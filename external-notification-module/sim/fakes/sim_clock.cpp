@@ -0,0 +1,124 @@
+#include "sim_clock.h"
+
+/**************************global variables***********************************/
+SimCounters sim_counters;
+
+static uint64_t sim_now_us = 0;
+static SimTimer sim_timers[SIM_TIMERS];
+static uint8_t sim_timer_count = 0;
+static uint64_t (*sim_next_input_us)(void) = 0;
+static uint64_t sim_standby_from_us = UINT64_MAX; // UINT64_MAX while awake
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+uint64_t simMicros(void)
+{
+  return sim_now_us;
+}
+
+uint64_t simTimer0Us(void)
+{
+  uint64_t standby_us = sim_counters.standby_us;
+  if (sim_standby_from_us != UINT64_MAX)
+  {
+    standby_us += sim_now_us - sim_standby_from_us;
+  }
+  return sim_now_us - standby_us;
+}
+
+void simAdvanceTo(uint64_t at_us)
+{
+  // due ticks in time order, a tick may set or move another timer
+  for (;;)
+  {
+    SimTimer *due = 0;
+    for (uint8_t i = 0; i < sim_timer_count; i++)
+    {
+      if (sim_timers[i].next_us <= at_us && (due == 0 || sim_timers[i].next_us < due->next_us))
+      {
+        due = &sim_timers[i];
+      }
+    }
+    if (due == 0)
+    {
+      break;
+    }
+    sim_now_us = due->next_us;
+    due->next_us += due->period_us;
+    due->tick();
+  }
+  if (at_us > sim_now_us)
+  {
+    sim_now_us = at_us;
+  }
+}
+
+void simAdvance(uint64_t us)
+{
+  simAdvanceTo(sim_now_us + us);
+}
+
+bool simWaitForInput(uint64_t deadline_us)
+{
+  uint64_t next = (sim_next_input_us != 0) ? sim_next_input_us() : UINT64_MAX;
+  if (next > deadline_us)
+  {
+    simAdvanceTo(deadline_us);
+    return false;
+  }
+  simAdvanceTo(next);
+  return true;
+}
+
+void simSetTimer(uint32_t period_us, void (*tick)(void))
+{
+  SimTimer *timer = 0;
+  for (uint8_t i = 0; i < sim_timer_count; i++)
+  {
+    if (sim_timers[i].tick == tick)
+    {
+      timer = &sim_timers[i];
+    }
+  }
+  if (timer == 0)
+  {
+    if (sim_timer_count == SIM_TIMERS)
+    {
+      return;
+    }
+    timer = &sim_timers[sim_timer_count++];
+  }
+  timer->period_us = period_us;
+  timer->next_us = sim_now_us + period_us;
+  timer->tick = tick;
+}
+
+uint64_t simTimerNextUs(void (*tick)(void))
+{
+  uint64_t next = UINT64_MAX;
+  for (uint8_t i = 0; i < sim_timer_count; i++)
+  {
+    if ((tick == 0 || sim_timers[i].tick == tick) && sim_timers[i].next_us < next)
+    {
+      next = sim_timers[i].next_us;
+    }
+  }
+  return next;
+}
+
+void simStandbyBegin(void)
+{
+  sim_standby_from_us = sim_now_us;
+}
+
+void simStandbyEnd(void)
+{
+  sim_counters.standby_us += sim_now_us - sim_standby_from_us;
+  sim_standby_from_us = UINT64_MAX;
+}
+
+void simSetInputSource(uint64_t (*next_input_us)(void))
+{
+  sim_next_input_us = next_input_us;
+}
+/*****************************************************************************/
@@ -0,0 +1,73 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdint.h>
+
+/**************************Virtual Clock**************************************/
+// Every fake charges the time its real counterpart would take on a 16 MHz
+// Uno to one virtual microsecond clock. Nothing sleeps on the host, so a
+// trace of hours replays in milliseconds and always gives the same numbers.
+
+// cost model, microseconds
+#define SIM_UART_BYTE_US 1042   // 9600 baud, 10 bits per byte
+#define SIM_UART_TX_BUFFER 64   // HardwareSerial TX ring on the Uno
+#define SIM_I2C_BYTE_US 90      // 100 kHz, 8 bits + ack
+#define SIM_LCD_PULSE_US 51     // LiquidCrystal_I2C pulseEnable() delays
+#define SIM_LCD_CLEAR_US 2000   // clear() and home() wait for the HD44780
+#define SIM_RTC_BYTE_US 112     // ThreeWire bit-banging, 8 x ~14 us
+#define SIM_DIGITAL_WRITE_US 4  // digitalWrite() on the Uno
+#define SIM_LOOP_US 20          // bookkeeping of one loop() pass
+
+// ATmega328P supply current at 5 V, 16 MHz, datasheet typical values; the
+// LCD backlight, HC-06 and relays are not included
+#define SIM_ACTIVE_UA 9000
+#define SIM_IDLE_UA 2600
+#define SIM_STANDBY_UA 600      // the resonator keeps running
+
+typedef struct _SSimCounters
+{
+  uint32_t i2c_bytes;        // bytes on the I2C wire, address bytes included
+  uint32_t lcd_writes;       // characters and commands sent to the LCD
+  uint32_t rtc_bytes;        // bytes clocked over the DS1302 three-wire bus
+  uint32_t rtc_reads;        // GetDateTime() calls
+  uint32_t serial_tx_bytes;  // bytes written to Serial
+  uint64_t serial_block_us;  // time Serial.write() waited for buffer space
+  uint32_t bt_rx_bytes;      // bytes read from the Bluetooth module
+  uint32_t digital_writes;
+  uint64_t idle_us;          // slept in idle mode (Timer1 or UART busy)
+  uint64_t standby_us;       // slept in standby mode
+} SimCounters;
+
+#define SIM_TIMERS 4
+
+typedef struct _SSimTimer
+{
+  uint32_t period_us;
+  uint64_t next_us;
+  void (*tick)(void);
+} SimTimer;
+
+extern SimCounters sim_counters;
+
+uint64_t simMicros(void);
+void simAdvance(uint64_t us);       // charge time, runs due timer ticks
+void simAdvanceTo(uint64_t at_us);  // no-op if at_us is in the past
+// waits at most until deadline_us for the next input event, returns false
+// if nothing arrives before the deadline
+bool simWaitForInput(uint64_t deadline_us);
+
+// periodic interrupt stand-ins, e.g. the buzzer's Timer1 compare and the
+// watchdog; one timer per tick function, setting it again restarts it
+void simSetTimer(uint32_t period_us, void (*tick)(void));
+// next tick of that timer, of any timer if tick is 0; UINT64_MAX if none
+uint64_t simTimerNextUs(void (*tick)(void));
+
+// Timer0 stops in standby, millis() and micros() count simTimer0Us()
+void simStandbyBegin(void);
+void simStandbyEnd(void);    // adds the time since simStandbyBegin() to standby_us
+uint64_t simTimer0Us(void);  // virtual time minus standby
+// next time an input event is due, UINT64_MAX if none
+void simSetInputSource(uint64_t (*next_input_us)(void));
+/*****************************************************************************/
+
+#endif
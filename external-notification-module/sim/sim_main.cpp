@@ -0,0 +1,395 @@
+/**************************Notification module simulation*********************/
+// Runs setup() and loop() of src/main.cpp against the fakes in sim/fakes,
+// replays a trace of Bluetooth commands on the virtual clock and reports
+// per-command latency, loop() pass times, bus traffic, time spent asleep and
+// the final LCD.
+//
+//   program [--rtc "YYYY-MM-DD hh:mm:ss"] [--tail ms] [--serial] file.trace
+//   program --check      buzzer pattern checks only, see buzzer_check.h
+//
+// Trace lines ('#' starts a comment):
+//   <ms> <text>          phone sends <text> + '\n', <ms> after setup() returned
+//   expect <row> <text>  LCD row must start with <text> when the replay ends
+//   expect bt <text>     firmware must have sent the line <text> to the phone
+//   expect serial <text> firmware must have logged the line <text> on Serial
+/*****************************************************************************/
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+#include <RtcDS1302.h>
+#include <SoftwareSerial.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "buzzer.h"
+#include "buzzer_check.h"
+#include "power.h"
+
+/**************************typedef *******************************************/
+typedef struct _SSimCommand
+{
+  std::string text;
+  uint64_t sent_us;     // first byte leaves the phone
+  uint64_t arrived_us;  // '\n' is in the receive buffer
+  uint32_t end_offset;  // total bytes read once this command is consumed
+  uint64_t handled_us;  // end of the loop() pass that consumed it
+  uint64_t pass_us;     // duration of that pass
+} SimCommand;
+
+// SimExpect rows of "expect bt" and "expect serial" lines
+#define SIM_EXPECT_BT 0xFF
+#define SIM_EXPECT_SERIAL 0xFE
+
+typedef struct _SSimExpect
+{
+  uint8_t row; // LCD row, SIM_EXPECT_BT or SIM_EXPECT_SERIAL
+  std::string text;
+} SimExpect;
+
+typedef struct _SSimOptions
+{
+  uint32_t rtc_start; // RtcDateTime seconds
+  uint32_t tail_ms;   // keep running after the last command arrived
+  bool serial;
+  bool check;         // run the buzzer checks instead of a trace
+  std::string trace_path;
+} SimOptions;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static void simUsage(void)
+{
+  std::cerr << "usage: program [--rtc \"YYYY-MM-DD hh:mm:ss\"] [--tail ms] [--serial] file.trace\n"
+               "       program --check\n";
+}
+
+static bool simParseRtc(const char *str, uint32_t *seconds)
+{
+  unsigned year, month, day, hour, minute, second;
+  if (sscanf(str, "%u-%u-%u %u:%u:%u", &year, &month, &day, &hour, &minute, &second) != 6 ||
+      year < 2000 || year > 2099 || month < 1 || month > 12)
+  {
+    return false;
+  }
+  *seconds = RtcDateTime(year, month, day, hour, minute, second).TotalSeconds();
+  return true;
+}
+
+static bool simParseArgs(int argc, char **argv, SimOptions *options)
+{
+  // a fixed start later than any build date, so initRtc() keeps it
+  simParseRtc("2030-01-01 08:00:00", &options->rtc_start);
+  options->tail_ms = 1000;
+  options->serial = false;
+  options->check = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--rtc" && i + 1 < argc)
+    {
+      if (!simParseRtc(argv[++i], &options->rtc_start))
+      {
+        return false;
+      }
+    }
+    else if (arg == "--tail" && i + 1 < argc)
+    {
+      options->tail_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--serial")
+    {
+      options->serial = true;
+    }
+    else if (arg == "--check")
+    {
+      options->check = true;
+    }
+    else if (options->trace_path.empty() && arg[0] != '-')
+    {
+      options->trace_path = arg;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return options->check != !options->trace_path.empty();
+}
+
+static bool simLoadTrace(const std::string &path, std::vector<SimCommand> *commands,
+                         std::vector<SimExpect> *expects)
+{
+  std::ifstream file(path.c_str());
+  if (!file)
+  {
+    std::cerr << "cannot open " << path << "\n";
+    return false;
+  }
+
+  std::string line;
+  unsigned line_no = 0;
+  while (std::getline(file, line))
+  {
+    line_no++;
+    if (!line.empty() && line[line.length() - 1] == '\r')
+    {
+      line.erase(line.length() - 1);
+    }
+    std::string::size_type start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line[start] == '#')
+    {
+      continue;
+    }
+
+    std::istringstream fields(line.substr(start));
+    std::string head;
+    fields >> head;
+    std::string rest;
+    std::getline(fields >> std::ws, rest);
+
+    if (head == "expect")
+    {
+      SimExpect expect;
+      std::istringstream expect_fields(rest);
+      std::string target;
+      unsigned row = 0;
+      if (!(expect_fields >> target) ||
+          (target != "bt" && target != "serial" && (sscanf(target.c_str(), "%u", &row) != 1 || row > 3)))
+      {
+        std::cerr << path << ":" << line_no << ": bad expect row\n";
+        return false;
+      }
+      std::getline(expect_fields >> std::ws, expect.text);
+      expect.row = (target == "bt")       ? SIM_EXPECT_BT
+                   : (target == "serial") ? SIM_EXPECT_SERIAL
+                                          : (uint8_t)row;
+      expects->push_back(expect);
+    }
+    else
+    {
+      char *end;
+      double ms = strtod(head.c_str(), &end);
+      if (*end != '\0' || ms < 0)
+      {
+        std::cerr << path << ":" << line_no << ": expected <ms> <text> or expect <row> <text>\n";
+        return false;
+      }
+      SimCommand command = {rest, (uint64_t)(ms * 1000), 0, 0, 0, 0};
+      commands->push_back(command);
+    }
+  }
+  return true;
+}
+
+static uint64_t simPercentile(std::vector<uint64_t> values, double p)
+{
+  if (values.empty())
+  {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t idx = (size_t)(p * (values.size() - 1) + 0.5);
+  return values[idx];
+}
+
+static void simPrintStats(const char *name, const std::vector<uint64_t> &values)
+{
+  uint64_t sum = 0;
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    sum += values[i];
+  }
+  printf("  %-14s %8zu passes  mean %8.1f  p50 %8llu  p99 %8llu  max %8llu us\n", name,
+         values.size(), values.empty() ? 0.0 : (double)sum / values.size(),
+         (unsigned long long)simPercentile(values, 0.50),
+         (unsigned long long)simPercentile(values, 0.99),
+         (unsigned long long)simPercentile(values, 1.0));
+}
+
+static std::string simRtrim(const std::string &str)
+{
+  std::string::size_type end = str.find_last_not_of(' ');
+  return (end == std::string::npos) ? std::string() : str.substr(0, end + 1);
+}
+
+// true if output holds <line> as a whole "\r\n" terminated line
+static bool simSentLine(const std::string &output, const std::string &line)
+{
+  return ("\n" + output).find("\n" + line + "\r\n") != std::string::npos;
+}
+
+int main(int argc, char **argv)
+{
+  SimOptions options;
+  std::vector<SimCommand> commands;
+  std::vector<SimExpect> expects;
+
+  if (!simParseArgs(argc, argv, &options))
+  {
+    simUsage();
+    return 2;
+  }
+  if (options.check)
+  {
+    return buzzerCheckAll() ? 1 : 0;
+  }
+  if (!simLoadTrace(options.trace_path, &commands, &expects))
+  {
+    return 2;
+  }
+  std::stable_sort(commands.begin(), commands.end(),
+                   [](const SimCommand &a, const SimCommand &b) { return a.sent_us < b.sent_us; });
+
+  Serial.echo = options.serial;
+  simRtcSet(options.rtc_start);
+  simSetTimer(BUZZER_TICK_MS * 1000, buzzerTick); // Timer1 compare stand-in
+
+  setup();
+  simSetTimer(POWER_TICK_MS * 1000, powerTick); // watchdog, from powerInit() on
+  uint64_t setup_us = simMicros();
+  SimCounters setup_counters = sim_counters;
+
+  uint32_t offset = 0;
+  uint64_t end_us = setup_us;
+  for (size_t i = 0; i < commands.size(); i++)
+  {
+    std::string line = commands[i].text + "\n";
+    commands[i].sent_us += setup_us;
+    commands[i].arrived_us = simBtSchedule(commands[i].sent_us, line.c_str());
+    offset += (uint32_t)line.length();
+    commands[i].end_offset = offset;
+    end_us = std::max(end_us, commands[i].arrived_us);
+  }
+  end_us += (uint64_t)options.tail_ms * 1000;
+
+  std::vector<uint64_t> idle_passes, command_passes;
+  size_t next_command = 0;
+  while (simMicros() < end_us)
+  {
+    uint64_t pass_start = simMicros();
+    uint64_t slept_before = sim_counters.idle_us + sim_counters.standby_us;
+    loop();
+    simAdvance(SIM_LOOP_US);
+    // loop() ends in powerSleep(), count the awake part only
+    uint64_t slept_us = sim_counters.idle_us + sim_counters.standby_us - slept_before;
+    uint64_t pass_us = simMicros() - pass_start - slept_us;
+
+    bool handled = false;
+    while (next_command < commands.size() && simBtBytesRead() >= commands[next_command].end_offset)
+    {
+      commands[next_command].handled_us = simMicros() - slept_us;
+      commands[next_command].pass_us = pass_us;
+      next_command++;
+      handled = true;
+    }
+    (handled ? command_passes : idle_passes).push_back(pass_us);
+  }
+
+  /* report */
+  printf("trace %s: %zu commands, %.3f s virtual time after setup() (setup %.1f ms)\n",
+         options.trace_path.c_str(), commands.size(), (simMicros() - setup_us) / 1e6, setup_us / 1e3);
+
+  printf("\ncommands%*s sent ms  air ms  pass ms  latency ms\n", 26, "");
+  for (size_t i = 0; i < commands.size(); i++)
+  {
+    const SimCommand &command = commands[i];
+    if (command.handled_us == 0)
+    {
+      printf("  %-32s %8.1f  not handled\n", command.text.c_str(), (command.sent_us - setup_us) / 1e3);
+      continue;
+    }
+    printf("  %-32s %8.1f %7.1f %8.1f %11.1f\n", command.text.c_str(),
+           (command.sent_us - setup_us) / 1e3, (command.arrived_us - command.sent_us) / 1e3,
+           command.pass_us / 1e3, (command.handled_us - command.sent_us) / 1e3);
+  }
+
+  printf("\nloop()\n");
+  simPrintStats("idle", idle_passes);
+  simPrintStats("with command", command_passes);
+
+  printf("\ntraffic after setup()\n");
+  printf("  i2c      %8u bytes  %6u lcd writes\n", sim_counters.i2c_bytes - setup_counters.i2c_bytes,
+         sim_counters.lcd_writes - setup_counters.lcd_writes);
+  printf("  rtc      %8u bytes  %6u reads\n", sim_counters.rtc_bytes - setup_counters.rtc_bytes,
+         sim_counters.rtc_reads - setup_counters.rtc_reads);
+  printf("  serial   %8u bytes  %9.1f ms blocked\n",
+         sim_counters.serial_tx_bytes - setup_counters.serial_tx_bytes,
+         (sim_counters.serial_block_us - setup_counters.serial_block_us) / 1e3);
+  printf("  bt rx    %8u bytes  %6u overflowed\n", sim_counters.bt_rx_bytes, simBtOverflows());
+
+  uint64_t run_us = simMicros() - setup_us;
+  uint64_t idle_us = sim_counters.idle_us - setup_counters.idle_us;
+  uint64_t standby_us = sim_counters.standby_us - setup_counters.standby_us;
+  uint64_t awake_us = run_us - idle_us - standby_us;
+  printf("\npower after setup()\n");
+  printf("  awake    %10.1f ms  %5.1f %%\n", awake_us / 1e3, 100.0 * awake_us / run_us);
+  printf("  idle     %10.1f ms  %5.1f %%\n", idle_us / 1e3, 100.0 * idle_us / run_us);
+  printf("  standby  %10.1f ms  %5.1f %%\n", standby_us / 1e3, 100.0 * standby_us / run_us);
+  printf("  mcu      %10.2f mA average (datasheet typ., without LCD and Bluetooth)\n",
+         ((double)awake_us * SIM_ACTIVE_UA + (double)idle_us * SIM_IDLE_UA +
+          (double)standby_us * SIM_STANDBY_UA) / run_us / 1e3);
+
+  printf("\npins\n");
+  for (uint8_t pin = 0; pin < SIM_PINS; pin++)
+  {
+    SimPin *sim_pin = &sim_pins[pin];
+    if (sim_pin->writes == 0)
+    {
+      continue;
+    }
+    uint64_t high_us = sim_pin->high_us + (sim_pin->level ? simMicros() - sim_pin->last_change_us : 0);
+    printf("  %2u  %6u writes  high %10.1f ms  now %s\n", pin, sim_pin->writes, high_us / 1e3,
+           sim_pin->level ? "HIGH" : "LOW");
+  }
+
+  int failures = 0;
+  if (sim_lcd != NULL)
+  {
+    std::string border(sim_lcd->cols(), '-');
+    printf("\nlcd%s\n  +%s+\n", sim_lcd->isBacklit() ? "" : " (backlight off)", border.c_str());
+    for (uint8_t row = 0; row < sim_lcd->rows(); row++)
+    {
+      printf("  |%s|\n", sim_lcd->row(row).c_str());
+    }
+    printf("  +%s+\n", border.c_str());
+
+    for (size_t i = 0; i < expects.size(); i++)
+    {
+      if (expects[i].row > 3)
+      {
+        continue;
+      }
+      std::string shown = sim_lcd->row(expects[i].row);
+      if (shown.compare(0, expects[i].text.length(), expects[i].text) != 0)
+      {
+        printf("FAIL row %u: \"%s\", expected \"%s\"\n", expects[i].row,
+               simRtrim(shown).c_str(), expects[i].text.c_str());
+        failures++;
+      }
+    }
+  }
+  for (size_t i = 0; i < expects.size(); i++)
+  {
+    if (expects[i].row == SIM_EXPECT_BT && !simSentLine(sim_bt_tx, expects[i].text))
+    {
+      printf("FAIL bt: \"%s\" never sent\n", expects[i].text.c_str());
+      failures++;
+    }
+    else if (expects[i].row == SIM_EXPECT_SERIAL && !simSentLine(Serial.output, expects[i].text))
+    {
+      printf("FAIL serial: \"%s\" never logged\n", expects[i].text.c_str());
+      failures++;
+    }
+  }
+  if (!expects.empty())
+  {
+    printf("\n%zu/%zu expectations met\n", expects.size() - failures, expects.size());
+  }
+  return failures ? 1 : 0;
+}
+/*****************************************************************************/
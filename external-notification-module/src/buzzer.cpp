@@ -0,0 +1,233 @@
+#include "buzzer.h"
+
+/**************************patterns (PROGMEM)*********************************/
+// {level, on_ticks, off_ticks, repeat}, one tick is BUZZER_TICK_MS
+const BuzzerStep steady_steps[] PROGMEM = {
+    {BUZZER_LEVEL_SET, 255, 0, 1}};
+const BuzzerStep beep_steps[] PROGMEM = {
+    {BUZZER_LEVEL_SET, 100, 0, 1}};
+const BuzzerStep triple_steps[] PROGMEM = {
+    {BUZZER_LEVEL_SET, 15, 15, 3}};
+const BuzzerStep escalate_steps[] PROGMEM = {
+    {LEVEL1, 20, 30, 3},
+    {LEVEL2, 20, 20, 3},
+    {LEVEL3, 30, 10, 5},
+    {LEVEL0, 1, 200, 1}};
+const BuzzerStep reminder_steps[] PROGMEM = {
+    {BUZZER_LEVEL_SET, 10, 190, 1}};
+
+// indexed by BuzzerPattern
+const BuzzerProgram buzzer_programs[BUZZER_PATTERNS] PROGMEM = {
+    {steady_steps, sizeof(steady_steps) / sizeof(BuzzerStep), 0},
+    {beep_steps, sizeof(beep_steps) / sizeof(BuzzerStep), 1},
+    {triple_steps, sizeof(triple_steps) / sizeof(BuzzerStep), 1},
+    {escalate_steps, sizeof(escalate_steps) / sizeof(BuzzerStep), 0},
+    {reminder_steps, sizeof(reminder_steps) / sizeof(BuzzerStep), 0}};
+/*****************************************************************************/
+
+/**************************global variables***********************************/
+static byte buzzer_out_pin = 0;
+static byte buzzer_relay_pin[2] = {0, 0};
+static BuzzerLevel buzzer_level = LEVEL1;
+
+// owned by buzzerTick() while playing, only touched elsewhere with interrupts off
+static BuzzerProgram buzzer_program;
+static BuzzerStep buzzer_step;
+static volatile bool buzzer_playing = false;
+static volatile bool buzzer_timed = false; // Timer1 runs
+static uint8_t buzzer_step_idx = 0;
+static uint8_t buzzer_beeps_left = 0;
+static uint8_t buzzer_ticks_left = 0;
+static uint8_t buzzer_loops_left = 0;
+static bool buzzer_phase_on = false;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+#if defined(__AVR__)
+static void buzzerTimerStart(void)
+{
+  // Timer1 CTC, 16 MHz / 64 / (2499 + 1) = 100 Hz
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  OCR1A = (F_CPU / 64 / (1000 / BUZZER_TICK_MS)) - 1;
+  TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+  TIFR1 = _BV(OCF1A);
+  TIMSK1 |= _BV(OCIE1A);
+}
+
+static void buzzerTimerStop(void)
+{
+  TIMSK1 &= ~_BV(OCIE1A);
+  TCCR1B = 0; // no clock source, the timer draws no power
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+  buzzerTick();
+}
+#else
+// host build: the caller drives buzzerTick() from its own clock
+static void buzzerTimerStart(void) {}
+static void buzzerTimerStop(void) {}
+#endif
+
+// relay ladder selects the volume, buzzer_pin switches the sound
+static void buzzerOutput(uint8_t level, bool on)
+{
+  if (level == BUZZER_LEVEL_SET)
+  {
+    level = buzzer_level;
+  }
+
+  // LEVEL0 mutes every pattern, fixed step levels included
+  if (!on || level == LEVEL0 || buzzer_level == LEVEL0)
+  {
+    digitalWrite(buzzer_out_pin, LOW);
+    return;
+  }
+
+  if (level == LEVEL1)
+  {
+    digitalWrite(buzzer_relay_pin[0], HIGH);
+  }
+  else if (level == LEVEL2)
+  {
+    digitalWrite(buzzer_relay_pin[0], LOW);
+    digitalWrite(buzzer_relay_pin[1], HIGH);
+  }
+  else if (level == LEVEL3)
+  {
+    digitalWrite(buzzer_relay_pin[0], LOW);
+    digitalWrite(buzzer_relay_pin[1], LOW);
+  }
+  digitalWrite(buzzer_out_pin, HIGH);
+}
+
+static void buzzerLoadStep(uint8_t idx)
+{
+  buzzer_step_idx = idx;
+  memcpy_P(&buzzer_step, &buzzer_program.steps[idx], sizeof(BuzzerStep));
+  buzzer_beeps_left = buzzer_step.repeat ? buzzer_step.repeat : 1;
+}
+
+static void buzzerStartBeep(void)
+{
+  buzzerOutput(buzzer_step.level, true);
+  buzzer_phase_on = true;
+  buzzer_ticks_left = buzzer_step.on_ticks ? buzzer_step.on_ticks : 1;
+}
+
+void buzzerInit(byte buzzer_pin, byte relay0_pin, byte relay1_pin)
+{
+  buzzer_out_pin = buzzer_pin;
+  buzzer_relay_pin[0] = relay0_pin;
+  buzzer_relay_pin[1] = relay1_pin;
+  pinMode(buzzer_relay_pin[0], OUTPUT);
+  pinMode(buzzer_relay_pin[1], OUTPUT);
+  pinMode(buzzer_out_pin, OUTPUT);
+  buzzerStop();
+}
+
+bool buzzerSetLevel(BuzzerLevel level)
+{
+  if ((unsigned)level > LEVEL3)
+  {
+    return false;
+  }
+  buzzer_level = level;
+  return true;
+}
+
+BuzzerLevel buzzerGetLevel(void)
+{
+  return buzzer_level;
+}
+
+bool buzzerPlay(BuzzerPattern pattern)
+{
+  if ((unsigned)pattern >= BUZZER_PATTERNS)
+  {
+    return false;
+  }
+
+  noInterrupts();
+  memcpy_P(&buzzer_program, &buzzer_programs[pattern], sizeof(BuzzerProgram));
+  buzzer_loops_left = buzzer_program.loops;
+  buzzerLoadStep(0);
+  buzzerStartBeep();
+  buzzer_playing = true;
+  // a single step that never turns off has nothing left to time
+  buzzer_timed = buzzer_program.step_count > 1 || buzzer_program.loops > 0 || buzzer_step.off_ticks > 0;
+  if (buzzer_timed)
+  {
+    buzzerTimerStart();
+  }
+  else
+  {
+    buzzerTimerStop();
+  }
+  interrupts();
+  return true;
+}
+
+void buzzerStop(void)
+{
+  noInterrupts();
+  buzzerTimerStop();
+  buzzer_playing = false;
+  buzzer_timed = false;
+  buzzer_phase_on = false;
+  digitalWrite(buzzer_out_pin, LOW);
+  interrupts();
+}
+
+bool buzzerIsPlaying(void)
+{
+  return buzzer_playing;
+}
+
+bool buzzerIsTimed(void)
+{
+  return buzzer_timed;
+}
+
+// one BUZZER_TICK_MS step of the current pattern, runs in interrupt context
+void buzzerTick(void)
+{
+  if (!buzzer_timed || --buzzer_ticks_left > 0)
+  {
+    return;
+  }
+
+  // on phase over, pause unless the step runs straight into the next beep
+  if (buzzer_phase_on && buzzer_step.off_ticks > 0)
+  {
+    buzzerOutput(buzzer_step.level, false);
+    buzzer_phase_on = false;
+    buzzer_ticks_left = buzzer_step.off_ticks;
+    return;
+  }
+
+  // beep over, move to the next beep, step or loop
+  if (--buzzer_beeps_left == 0)
+  {
+    uint8_t next = buzzer_step_idx + 1;
+    if (next == buzzer_program.step_count)
+    {
+      next = 0;
+      if (buzzer_loops_left > 0 && --buzzer_loops_left == 0)
+      {
+        buzzerTimerStop();
+        buzzer_playing = false;
+        buzzer_timed = false;
+        buzzer_phase_on = false;
+        digitalWrite(buzzer_out_pin, LOW);
+        return;
+      }
+    }
+    buzzerLoadStep(next);
+  }
+  buzzerStartBeep();
+}
+/*****************************************************************************/
@@ -0,0 +1,62 @@
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include <Arduino.h>
+
+/**************************Buzzer Pattern Engine******************************/
+// Patterns are tables of steps in PROGMEM. Once started with buzzerPlay(),
+// a pattern is stepped by buzzerTick() from the Timer1 compare interrupt
+// every BUZZER_TICK_MS, loop() does no work while it plays. The timer only
+// runs while a pattern is playing, and not for a pattern that is one beep
+// held until stopped (BUZZER_STEADY): its outputs are set once. On the host
+// there is no timer: the simulation calls buzzerTick() from its own virtual
+// clock instead.
+
+#define BUZZER_TICK_MS 10
+// step level that follows the level chosen with buzzerSetLevel()
+#define BUZZER_LEVEL_SET 0xFF
+
+typedef enum _EBuzzerLevel
+{
+  LEVEL0, // mute, silences every pattern
+  LEVEL1,
+  LEVEL2,
+  LEVEL3
+} BuzzerLevel;
+
+typedef enum _EBuzzerPattern
+{
+  BUZZER_STEADY,   // on until stopped
+  BUZZER_BEEP,     // one long beep
+  BUZZER_TRIPLE,   // three short beeps
+  BUZZER_ESCALATE, // LEVEL1 -> LEVEL3, repeats until stopped
+  BUZZER_REMINDER, // short chirp every 2 s until stopped
+  BUZZER_PATTERNS  // number of patterns
+} BuzzerPattern;
+
+typedef struct _SBuzzerStep
+{
+  uint8_t level;     // BuzzerLevel or BUZZER_LEVEL_SET
+  uint8_t on_ticks;  // 1..255
+  uint8_t off_ticks; // 0 keeps the buzzer on into the next beep
+  uint8_t repeat;    // beeps in this step, 1..255
+} BuzzerStep;
+
+typedef struct _SBuzzerProgram
+{
+  const BuzzerStep *steps; // PROGMEM
+  uint8_t step_count;
+  uint8_t loops; // 0 repeats until buzzerStop()
+} BuzzerProgram;
+
+void buzzerInit(byte buzzer_pin, byte relay0_pin, byte relay1_pin);
+bool buzzerSetLevel(BuzzerLevel level); // false if level is out of range
+BuzzerLevel buzzerGetLevel(void);
+bool buzzerPlay(BuzzerPattern pattern); // false if pattern is out of range
+void buzzerStop(void);
+bool buzzerIsPlaying(void);
+bool buzzerIsTimed(void); // playing on Timer1, which standby would stop
+void buzzerTick(void);
+/*****************************************************************************/
+
+#endif
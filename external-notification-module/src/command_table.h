@@ -0,0 +1,87 @@
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include <Arduino.h>
+#include <stddef.h>
+
+/**************************Command Dispatch Table*****************************/
+// Bluetooth commands are "module, item, value" lines (see parseString()).
+// Every (module, item) pair is hashed at compile time and stored with its
+// handler in a PROGMEM table; an incoming command is hashed once and its
+// handler is found through a fixed slot index, independent of table size.
+// Commands that only look at the module (e.g. "standby") use an empty item.
+
+// number of slots in the index, must be a power of two
+#define CMD_SLOTS 16
+// FNV-1a offset basis, change it if the build reports a slot collision
+#define CMD_HASH_SEED 2166136263UL
+#define CMD_NONE 0xFF
+
+typedef void (*CommandHandler)(void);
+
+typedef struct _SCommand
+{
+  uint16_t hash;
+  CommandHandler handler;
+} Command;
+
+constexpr uint32_t fnv1a(const char *str, uint32_t hash)
+{
+  return (*str == '\0') ? hash : fnv1a(str + 1, (hash ^ (uint8_t)*str) * 16777619UL);
+}
+
+constexpr uint16_t fold16(uint32_t hash)
+{
+  return (uint16_t)((hash >> 16) ^ (hash & 0xFFFF));
+}
+
+// FNV-1a state after "module,", shared by all items of a module
+constexpr uint32_t commandPrefix(const char *module)
+{
+  return fnv1a(",", fnv1a(module, CMD_HASH_SEED));
+}
+
+// usable both in constant expressions and at run time; the hash of
+// (module, "") is fold16(commandPrefix(module))
+constexpr uint16_t commandHash(const char *module, const char *item)
+{
+  return fold16(fnv1a(item, commandPrefix(module)));
+}
+
+constexpr uint8_t commandSlot(uint16_t hash)
+{
+  return (uint8_t)(hash & (CMD_SLOTS - 1));
+}
+
+// index of the table entry that owns a slot, CMD_NONE if the slot is free
+template <size_t N>
+constexpr uint8_t commandSlotEntry(const Command (&table)[N], uint8_t slot, size_t i = 0)
+{
+  return (i == N) ? CMD_NONE
+                  : (commandSlot(table[i].hash) == slot ? (uint8_t)i : commandSlotEntry(table, slot, i + 1));
+}
+
+// true if no two entries share a slot (and therefore no two share a hash)
+template <size_t N>
+constexpr bool commandSlotsUnique(const Command (&table)[N], size_t i = 0, size_t j = 1)
+{
+  return (i >= N) ? true
+         : (j >= N) ? commandSlotsUnique(table, i + 1, i + 2)
+                    : (commandSlot(table[i].hash) != commandSlot(table[j].hash) &&
+                       commandSlotsUnique(table, i, j + 1));
+}
+
+// looks up a PROGMEM table through its PROGMEM slot index, NULL if unknown
+template <size_t N>
+CommandHandler findCommand(const Command (&table)[N], const uint8_t *slots, uint16_t hash)
+{
+  uint8_t idx = pgm_read_byte(&slots[commandSlot(hash)]);
+  if (idx == CMD_NONE || pgm_read_word(&table[idx].hash) != hash)
+  {
+    return NULL;
+  }
+  return (CommandHandler)pgm_read_ptr(&table[idx].handler);
+}
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,206 @@
+#include "delivery_tracker.h"
+
+// id = gen * DELIVERY_CAPACITY + slot + 1 stays within 1..255
+#define DELIVERY_GENERATIONS (256 / DELIVERY_CAPACITY - 1)
+
+/**************************global variables***********************************/
+static Delivery delivery_pool[DELIVERY_CAPACITY];
+static uint8_t delivery_gen[DELIVERY_CAPACITY];  // bumped every time a slot is freed
+static uint8_t delivery_heap[DELIVERY_CAPACITY]; // pool slots, earliest ETA first
+static uint8_t delivery_pos[DELIVERY_CAPACITY];  // heap position of each slot
+static uint8_t delivery_free[DELIVERY_CAPACITY]; // stack of unused slots
+static uint8_t delivery_count = 0;
+static uint8_t delivery_free_count = 0;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static uint8_t deliverySlot(uint8_t id)
+{
+  return (id - 1) & (DELIVERY_CAPACITY - 1);
+}
+
+static uint32_t deliveryEta(uint8_t pos)
+{
+  return delivery_pool[delivery_heap[pos]].eta;
+}
+
+static void deliveryPlace(uint8_t pos, uint8_t slot)
+{
+  delivery_heap[pos] = slot;
+  delivery_pos[slot] = pos;
+}
+
+static void deliverySiftUp(uint8_t pos)
+{
+  uint8_t slot = delivery_heap[pos];
+  uint32_t eta = delivery_pool[slot].eta;
+  while (pos > 0)
+  {
+    uint8_t parent = (pos - 1) / 2;
+    if (deliveryEta(parent) <= eta)
+    {
+      break;
+    }
+    deliveryPlace(pos, delivery_heap[parent]);
+    pos = parent;
+  }
+  deliveryPlace(pos, slot);
+}
+
+static void deliverySiftDown(uint8_t pos)
+{
+  uint8_t slot = delivery_heap[pos];
+  uint32_t eta = delivery_pool[slot].eta;
+  for (;;)
+  {
+    uint8_t child = pos * 2 + 1;
+    if (child >= delivery_count)
+    {
+      break;
+    }
+    if (child + 1 < delivery_count && deliveryEta(child + 1) < deliveryEta(child))
+    {
+      child++;
+    }
+    if (eta <= deliveryEta(child))
+    {
+      break;
+    }
+    deliveryPlace(pos, delivery_heap[child]);
+    pos = child;
+  }
+  deliveryPlace(pos, slot);
+}
+
+static void deliveryRemoveAt(uint8_t pos)
+{
+  uint8_t slot = delivery_heap[pos];
+  delivery_pool[slot].id = DELIVERY_NONE;
+  delivery_gen[slot] = (delivery_gen[slot] + 1) % DELIVERY_GENERATIONS;
+  delivery_free[delivery_free_count++] = slot;
+
+  delivery_count--;
+  if (pos == delivery_count)
+  {
+    return;
+  }
+  deliveryPlace(pos, delivery_heap[delivery_count]);
+  if (pos > 0 && deliveryEta(pos) < deliveryEta((pos - 1) / 2))
+  {
+    deliverySiftUp(pos);
+  }
+  else
+  {
+    deliverySiftDown(pos);
+  }
+}
+
+// marks the subtree rooted at pos, skipping subtrees that are not due yet
+static void deliveryMarkOverdue(uint8_t pos, uint32_t now)
+{
+  if (pos >= delivery_count || deliveryEta(pos) > now)
+  {
+    return;
+  }
+  if (delivery_pool[delivery_heap[pos]].state == DELIVERY_PENDING)
+  {
+    delivery_pool[delivery_heap[pos]].state = DELIVERY_OVERDUE;
+  }
+  deliveryMarkOverdue(pos * 2 + 1, now);
+  deliveryMarkOverdue(pos * 2 + 2, now);
+}
+
+void deliveryInit(void)
+{
+  delivery_count = 0;
+  delivery_free_count = 0;
+  for (uint8_t slot = DELIVERY_CAPACITY; slot > 0; slot--)
+  {
+    delivery_pool[slot - 1].id = DELIVERY_NONE;
+    delivery_free[delivery_free_count++] = slot - 1;
+  }
+}
+
+uint8_t deliveryAdd(uint32_t eta)
+{
+  if (delivery_free_count == 0)
+  {
+    return DELIVERY_NONE;
+  }
+
+  uint8_t slot = delivery_free[--delivery_free_count];
+  delivery_pool[slot].id = delivery_gen[slot] * DELIVERY_CAPACITY + slot + 1;
+  delivery_pool[slot].eta = eta;
+  delivery_pool[slot].state = DELIVERY_PENDING;
+
+  deliveryPlace(delivery_count, slot);
+  delivery_count++;
+  deliverySiftUp(delivery_count - 1);
+  return delivery_pool[slot].id;
+}
+
+bool deliveryComplete(uint8_t id)
+{
+  if (id == DELIVERY_NONE)
+  {
+    return false;
+  }
+
+  uint8_t slot = deliverySlot(id);
+  if (delivery_pool[slot].id != id)
+  {
+    return false;
+  }
+  deliveryRemoveAt(delivery_pos[slot]);
+  return true;
+}
+
+uint8_t deliveryCompleteNext(void)
+{
+  if (delivery_count == 0)
+  {
+    return DELIVERY_NONE;
+  }
+
+  uint8_t id = delivery_pool[delivery_heap[0]].id;
+  deliveryRemoveAt(0);
+  return id;
+}
+
+void deliveryMarkArriving(void)
+{
+  if (delivery_count > 0)
+  {
+    delivery_pool[delivery_heap[0]].state = DELIVERY_ARRIVING;
+  }
+}
+
+void deliveryUpdate(uint32_t now)
+{
+  deliveryMarkOverdue(0, now);
+}
+
+uint8_t deliveryCount(void)
+{
+  return delivery_count;
+}
+
+uint8_t deliveryNext(const Delivery *next[2])
+{
+  if (delivery_count == 0)
+  {
+    return 0;
+  }
+
+  next[0] = &delivery_pool[delivery_heap[0]];
+  if (delivery_count == 1)
+  {
+    return 1;
+  }
+
+  // the second earliest is one of the root's children
+  uint8_t second = (delivery_count > 2 && deliveryEta(2) < deliveryEta(1)) ? 2 : 1;
+  next[1] = &delivery_pool[delivery_heap[second]];
+  return 2;
+}
+/*****************************************************************************/
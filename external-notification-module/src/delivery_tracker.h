@@ -0,0 +1,41 @@
+#ifndef DELIVERY_TRACKER_H
+#define DELIVERY_TRACKER_H
+
+#include <Arduino.h>
+
+/**************************Delivery Tracker***********************************/
+// Outstanding deliveries in a fixed-size binary min-heap ordered by ETA.
+// Entries live in a static pool; the heap holds pool slots and every slot
+// remembers its heap position, so insert and remove by id are O(log n).
+// An id encodes its pool slot plus a per-slot generation, so a stale id
+// from a finished delivery never completes a newer one.
+
+#define DELIVERY_CAPACITY 8 // must be a power of two, ids stay below 256
+#define DELIVERY_NONE 0
+
+typedef enum _EDeliveryState
+{
+  DELIVERY_PENDING,  // on its way
+  DELIVERY_ARRIVING, // motion seen while it was the next one due
+  DELIVERY_OVERDUE   // ETA passed without an end command
+} DeliveryState;
+
+typedef struct _SDelivery
+{
+  uint32_t eta; // RTC seconds since 2000-01-01
+  uint8_t id;   // DELIVERY_NONE if the slot is free
+  uint8_t state; // DeliveryState
+} Delivery;
+
+void deliveryInit(void);
+uint8_t deliveryAdd(uint32_t eta);  // new id, DELIVERY_NONE if full
+bool deliveryComplete(uint8_t id);  // false if the id is not outstanding
+uint8_t deliveryCompleteNext(void); // id of the earliest, DELIVERY_NONE if empty
+void deliveryMarkArriving(void);    // earliest one becomes DELIVERY_ARRIVING
+void deliveryUpdate(uint32_t now);  // flags everything due by now as overdue
+uint8_t deliveryCount(void);
+// fills next[] with the (at most two) earliest deliveries, returns how many
+uint8_t deliveryNext(const Delivery *next[2]);
+/*****************************************************************************/
+
+#endif
@@ -6,6 +6,13 @@
 #include <RtcDS1302.h>
 #include <time.h>
 
+#include <Log.h>
+
+#include "buzzer.h"
+#include "command_table.h"
+#include "delivery_tracker.h"
+#include "power.h"
+
 /**************************typedef *******************************************/
 typedef enum _ELcdControl
 {
@@ -16,13 +23,16 @@ typedef enum _ELcdControl
   LCDINIT
 } LcdControl;
 
-typedef enum _EBuzzerLevel
+typedef enum _ELogId // rate limiter id per message source
 {
-  LEVEL0,
-  LEVEL1,
-  LEVEL2,
-  LEVEL3
-} BuzzerLevel;
+  LOG_ID_LCD,
+  LOG_ID_BUZZER,
+  LOG_ID_TIME,
+  LOG_ID_BT_RX,
+  LOG_ID_BT_IDLE,
+  LOG_ID_COMMAND,
+  LOG_ID_DELIVERY
+} LogId;
 /*****************************************************************************/
 
 /***********************pin numbers, device info constants *******************/
@@ -40,6 +50,9 @@ const byte lcd_row = 4;
 const byte rtc_clk_pin = 9;
 const byte rtc_dat_pin = 10;
 const byte rtc_rst_pin = 11;
+
+const byte trace_eid_len = 8; // camera event ids are 8 hex digits
+const uint16_t arrv_minute_max = 65535; // longest ETA of "delivery, start", ~45 days
 /*****************************************************************************/
 
 /**************************global variables***********************************/
@@ -49,11 +62,11 @@ LiquidCrystal_I2C lcd(lcd_adrr, lcd_col, lcd_row);
 ThreeWire rtc_wire(rtc_dat_pin, rtc_clk_pin, rtc_rst_pin);
 RtcDS1302<ThreeWire> rtc(rtc_wire);
 String received_str = "";
+unsigned long received_ms = 0; // powerMillis() when received_str came in
 String header_module = "", header_item = "", header_value = "";
 String time_form_str = "";
-uint16_t arrv_time = 0;
 uint8_t last_minute = 0;
-BuzzerLevel buzzer_level = LEVEL1;
+BuzzerPattern alert_pattern = BUZZER_STEADY; // played on delivery end and "on"
 /*****************************************************************************/
 
 /***************user-defined functions****************************************/
@@ -75,40 +88,27 @@ void parseString(void)
   header_value.trim();
 }
 
-void setBuzzerLevel(BuzzerLevel level)
-{
-  buzzer_level = level;
-}
-
-void turnOnBuzzer(void)
+// a delivery id as handed out by deliveryAdd(), 1..255 and digits only
+bool parseDeliveryId(const String &str, uint8_t *id)
 {
-  //Buzzer noise occurs at different levels of volume
-  //level0 is mute
-  if (buzzer_level == LEVEL0)
-  {
-    digitalWrite(buzzer_pin, LOW);
-  }
-  else if (buzzer_level == LEVEL1)
+  if (str.length() == 0 || str.length() > 3)
   {
-    digitalWrite(relay_pin[0], HIGH);
-    digitalWrite(buzzer_pin, HIGH);
+    return false;
   }
-  else if (buzzer_level == LEVEL2)
+  for (unsigned int i = 0; i < str.length(); i++)
   {
-    digitalWrite(relay_pin[0], LOW);
-    digitalWrite(relay_pin[1], HIGH);
-    digitalWrite(buzzer_pin, HIGH);
-  }
-  else if (buzzer_level == LEVEL3)
-  {
-    digitalWrite(relay_pin[0], LOW);
-    digitalWrite(relay_pin[1], LOW);
-    digitalWrite(buzzer_pin, HIGH);
+    if (str[i] < '0' || str[i] > '9')
+    {
+      return false;
+    }
   }
-  else
+  long value = str.toInt();
+  if (value < 1 || value > 255)
   {
-    Serial.println("buzzer level error");
+    return false;
   }
+  *id = (uint8_t)value;
+  return true;
 }
 
 void getTimeNow(uint16_t *hour, uint16_t *min, uint16_t *day, uint16_t *month, uint16_t *year)
@@ -127,7 +127,7 @@ void getTimeFormString(uint16_t hour, uint16_t min, uint16_t day, uint16_t month
   time_fstr = (char *)malloc(18 * sizeof(char));
   sprintf(time_fstr, "%02u:%02u|%4u-%02u-%02u", hour, min, year, month, day);
   time_form_str = String(time_fstr);
-  Serial.println("time is: " + time_form_str);
+  LOG_DEBUG(LOG_ID_TIME, "time is: %s", time_form_str.c_str());
   free(time_fstr);
 }
 
@@ -148,17 +148,83 @@ void getTimeFormStringArrv(uint16_t arrv_minute)
   hour_new = (hour + ((min+arrv_minute) / 60)) % 24;
 
   char *time_fstr = (char *)malloc(18 * sizeof(char));
-  sprintf(time_fstr, "%02u:%02u|", hour_new, min);
+  sprintf(time_fstr, "%02u:%02u|", hour_new, min_new);
   time_form_str = String(time_fstr);
   free(time_fstr);
 }
 
+void getDeliveryCountdown(const Delivery *delivery, uint32_t now)
+{
+  char countdown_fstr[12];
+  uint32_t minutes = (delivery->eta > now) ? (delivery->eta - now + 59) / 60 : 0;
+
+  if (delivery->state == DELIVERY_ARRIVING)
+  {
+    sprintf(countdown_fstr, "#%u here", delivery->id);
+  }
+  else if (delivery->state == DELIVERY_OVERDUE || minutes == 0)
+  {
+    sprintf(countdown_fstr, "#%u due", delivery->id);
+  }
+  else if (minutes < 100)
+  {
+    sprintf(countdown_fstr, "#%u %um", delivery->id, (unsigned)minutes);
+  }
+  else if (minutes / 60 < 100)
+  {
+    sprintf(countdown_fstr, "#%u %uh", delivery->id, (unsigned)(minutes / 60));
+  }
+  else
+  {
+    sprintf(countdown_fstr, "#%u >99h", delivery->id);
+  }
+  time_form_str.concat(countdown_fstr);
+}
+
+// next two arrivals as countdowns, e.g. "#1 12m #9 45m +2"
+void getTimeFormStringCountdown(void)
+{
+  const Delivery *next[2];
+  uint8_t shown = deliveryNext(next);
+  uint32_t now = rtc.GetDateTime().TotalSeconds();
+
+  time_form_str = "";
+  for (uint8_t i = 0; i < shown; i++)
+  {
+    if (i > 0)
+    {
+      time_form_str.concat(' ');
+    }
+    getDeliveryCountdown(next[i], now);
+  }
+  if (deliveryCount() > shown)
+  {
+    time_form_str.concat(" +");
+    time_form_str.concat(deliveryCount() - shown);
+  }
+  if (shown == 0)
+  {
+    time_form_str = "--:--|";
+  }
+
+  // clip to the line and blank out what an older, longer text left behind
+  const byte width = lcd_col - 4; // after "EXP:"
+  if (time_form_str.length() > width)
+  {
+    time_form_str.remove(width);
+  }
+  while (time_form_str.length() < width)
+  {
+    time_form_str.concat(' ');
+  }
+}
+
 void lcdPrintStatus(LcdControl lcd_control)
 {
   /* LCD Display
   LCD Display Example
   NOW:08:15|2021-08-21
-  EXP:08:45|
+  EXP:#1 12m #9 45m +2
   MOTION DETECTED!
   DELIVERY COMPLETE!!! */
   switch (lcd_control)
@@ -168,8 +234,8 @@ void lcdPrintStatus(LcdControl lcd_control)
     getTimeFormStringNow();
     lcd.print("NOW:" + time_form_str); // Display Current Time
     lcd.setCursor(0, 1);
-    getTimeFormStringArrv(arrv_time);
-    lcd.print("EXP:" + time_form_str); // Display estimated arrival time
+    getTimeFormStringCountdown();
+    lcd.print("EXP:" + time_form_str); // Display countdowns to the next arrivals
     lcd.setCursor(0, 2);
     lcd.print("MOTION CHECKING..."); // Display if motion is detected
     break;
@@ -179,6 +245,11 @@ void lcdPrintStatus(LcdControl lcd_control)
     last_minute = rtc.GetDateTime().Minute();
     lcd.print("NOW:" + time_form_str); // Display Current Time
     break;
+  case TIME_ARRV_LINE1:
+    lcd.setCursor(0, 1);
+    getTimeFormStringCountdown();
+    lcd.print("EXP:" + time_form_str); // Display countdowns to the next arrivals
+    break;
   case MOTION_LINE2:
     lcd.setCursor(0, 2);
     lcd.print("MOTION DETECTED!!"); // Motion Detection Notification
@@ -188,149 +259,269 @@ void lcdPrintStatus(LcdControl lcd_control)
     lcd.print("DELIVERY COMPLETE!!"); // Delivery End Notification
     break;
   default:
-    Serial.println("error: lcd control");
+    LOG_ERROR(LOG_ID_LCD, "error: lcd control");
   }
 }
 
-void turnOnBuzzerAtLevel(BuzzerLevel level)
-{
-  setBuzzerLevel(level);
-  turnOnBuzzer();
-}
-
 void initRtc(void)
 {
-  Serial.print("compiled: ");
-  Serial.print(__DATE__);
-  Serial.println(__TIME__);
+  LOG_INFO(LOG_ID_NONE, "compiled: %s %s", __DATE__, __TIME__);
   rtc.Begin();
   RtcDateTime compiled_date_time = RtcDateTime(__DATE__, __TIME__);
 
   if (rtc.GetIsWriteProtected())
   {
-    Serial.println("RTC was write protected, enabling writing now");
+    LOG_WARN(LOG_ID_NONE, "RTC write protected, enabling writing");
     rtc.SetIsWriteProtected(false);
   }
 
   if (!rtc.GetIsRunning())
   {
-    Serial.println("RTC was not actively running, starting now");
+    LOG_WARN(LOG_ID_NONE, "RTC was not running, starting now");
     rtc.SetIsRunning(true);
   }
 
   RtcDateTime now = rtc.GetDateTime();
   if (now < compiled_date_time)
   {
-    Serial.println("RTC is older than compile time!  (Updating DateTime)");
+    LOG_WARN(LOG_ID_NONE, "RTC older than compile time, updating");
     rtc.SetDateTime(compiled_date_time);
   }
   else if (now > compiled_date_time)
   {
-    Serial.println("RTC is newer than compile time. (this is expected)");
+    LOG_INFO(LOG_ID_NONE, "RTC newer than compile time (expected)");
   }
   else if (now == compiled_date_time)
   {
-    Serial.println("RTC is the same as compile time! (not expected but all is fine)");
+    LOG_INFO(LOG_ID_NONE, "RTC same as compile time (fine)");
   }
 }
 
 void updateTime()
 {
-  if (rtc.GetDateTime().Minute() != last_minute)
+  RtcDateTime now = rtc.GetDateTime();
+  if (now.Minute() != last_minute)
   {
     lcdPrintStatus(TIME_NOW_LINE0);
+    if (deliveryCount() > 0)
+    {
+      deliveryUpdate(now.TotalSeconds());
+      lcdPrintStatus(TIME_ARRV_LINE1);
+    }
+  }
+}
+/*****************************************************************************/
+
+/***************command handlers**********************************************/
+//1 Blocks on Delivery
+//1.1 Delivery Start
+void onDeliveryStart(void)
+{
+  long arrv_minute = header_value.toInt();
+  if (arrv_minute < 0)
+  {
+    arrv_minute = 0;
+  }
+  else if (arrv_minute > arrv_minute_max)
+  {
+    LOG_WARN(LOG_ID_DELIVERY, "delivery eta over %u min", arrv_minute_max);
+    return;
+  }
+
+  uint8_t id = deliveryAdd(rtc.GetDateTime().TotalSeconds() + (uint32_t)arrv_minute * 60);
+  if (id == DELIVERY_NONE)
+  {
+    LOG_WARN(LOG_ID_DELIVERY, "delivery list full");
+    return;
   }
+  // the app needs the id for "delivery, end, <id>"
+  bt_serial.print(F("delivery, id, "));
+  bt_serial.println(id);
+  getTimeFormStringArrv(arrv_minute);
+  LOG_INFO(LOG_ID_NONE, "delivery #%u eta %s", id, time_form_str.c_str());
+
+  lcd.clear();
+  buzzerStop();
+  lcdPrintStatus(LCDINIT);
+}
+
+//1.2 Delivery complete
+// "delivery, end, <id>" completes that delivery, without an id the earliest
+void onDeliveryEnd(void)
+{
+  uint8_t id;
+  if (header_value.length() == 0)
+  {
+    deliveryCompleteNext();
+  }
+  else if (!parseDeliveryId(header_value, &id) || !deliveryComplete(id))
+  {
+    LOG_WARN(LOG_ID_DELIVERY, "no delivery #%s", header_value.c_str());
+    return;
+  }
+  lcdPrintStatus(TIME_ARRV_LINE1);
+  lcdPrintStatus(DELIVERY_END_LINE3);
+  buzzerPlay(alert_pattern);
+}
+
+//2 Blocks on Buzzer
+//2.1 buzzer on/off control
+void onBuzzerOnOff(void)
+{
+  if (header_value.equals("on"))
+  {
+    buzzerPlay(alert_pattern);
+  }
+  else if (header_value.equals("off"))
+  {
+    buzzerStop();
+  }
+}
+
+//2.2 Buzer volume control
+void onBuzzerLevel(void)
+{
+  if (!buzzerSetLevel((BuzzerLevel)header_value.toInt()))
+  {
+    LOG_ERROR(LOG_ID_BUZZER, "buzzer level error");
+  }
+}
+
+//2.3 Alert pattern selection, e.g. "buzzer, pattern, 3"
+void onBuzzerPattern(void)
+{
+  BuzzerPattern pattern = (BuzzerPattern)header_value.toInt();
+  if ((unsigned)pattern >= BUZZER_PATTERNS)
+  {
+    LOG_ERROR(LOG_ID_BUZZER, "buzzer pattern error");
+    return;
+  }
+  alert_pattern = pattern;
+}
+
+//2.4 Play a pattern once now, e.g. "buzzer, play, 2"
+void onBuzzerPlay(void)
+{
+  if (!buzzerPlay((BuzzerPattern)header_value.toInt()))
+  {
+    LOG_ERROR(LOG_ID_BUZZER, "buzzer pattern error");
+  }
+}
+
+//3 Blocks on Motion
+void onMotion(void)
+{
+  // "motion, <label>, <eid>", the camera's event id if the app passed it on
+  String eid = header_value.length() ? header_value.substring(0, trace_eid_len) : String("-");
+  eid.replace(' ', '_');
+  LOG_TRACE(eid.c_str(), "bt_rx", received_ms);
+
+  deliveryMarkArriving();
+  lcdPrintStatus(TIME_ARRV_LINE1);
+  lcdPrintStatus(MOTION_LINE2);
+  LOG_TRACE(eid.c_str(), "lcd_drawn", powerMillis());
+}
+
+//4 Blocks on Standby
+void onStandby(void)
+{
+  buzzerStop();
+  lcd.clear();
+  lcdPrintStatus(TIME_NOW_LINE0);
+}
+/*****************************************************************************/
+
+/**************************command table**************************************/
+// (module, item) -> handler, an empty item matches any item of the module
+constexpr Command command_table[] PROGMEM = {
+    {commandHash("delivery", "start"), onDeliveryStart},
+    {commandHash("delivery", "end"), onDeliveryEnd},
+    {commandHash("buzzer", "on/off"), onBuzzerOnOff},
+    {commandHash("buzzer", "level"), onBuzzerLevel},
+    {commandHash("buzzer", "pattern"), onBuzzerPattern},
+    {commandHash("buzzer", "play"), onBuzzerPlay},
+    {commandHash("motion", ""), onMotion},
+    {commandHash("standby", ""), onStandby},
+};
+
+static_assert(sizeof(command_table) / sizeof(command_table[0]) <= CMD_SLOTS,
+              "command table is larger than CMD_SLOTS");
+static_assert(commandSlotsUnique(command_table),
+              "command slot collision, change CMD_HASH_SEED");
+static_assert(CMD_SLOTS == 16, "command_slots below lists 16 slots");
+
+#define CMD_SLOT(slot) commandSlotEntry(command_table, slot)
+const uint8_t command_slots[CMD_SLOTS] PROGMEM = {
+    CMD_SLOT(0), CMD_SLOT(1), CMD_SLOT(2), CMD_SLOT(3),
+    CMD_SLOT(4), CMD_SLOT(5), CMD_SLOT(6), CMD_SLOT(7),
+    CMD_SLOT(8), CMD_SLOT(9), CMD_SLOT(10), CMD_SLOT(11),
+    CMD_SLOT(12), CMD_SLOT(13), CMD_SLOT(14), CMD_SLOT(15)};
+#undef CMD_SLOT
+
+void dispatchCommand(void)
+{
+  // the module is hashed once, for both the full and the module-only match
+  uint32_t prefix = commandPrefix(header_module.c_str());
+  CommandHandler handler = findCommand(command_table, command_slots,
+                                       fold16(fnv1a(header_item.c_str(), prefix)));
+  if (handler == NULL)
+  {
+    handler = findCommand(command_table, command_slots, fold16(prefix));
+  }
+
+  if (handler == NULL)
+  {
+    LOG_WARN(LOG_ID_COMMAND, "error: unknown command");
+    return;
+  }
+  handler();
 }
 /*****************************************************************************/
 void setup()
 {
   Serial.begin(9600);    // For local diagnostics
+  logBegin(&Serial);     // buffered, drained by logFlush() in loop()
   bt_serial.begin(9600); // Convert Bluetooth to Serial Communication
   initRtc();
+  logFlushAll();
   lcd.init();
   lcd.backlight();
-  pinMode(relay_pin[0], OUTPUT);
-  pinMode(relay_pin[1], OUTPUT);
-  pinMode(buzzer_pin, OUTPUT);
+  buzzerInit(buzzer_pin, relay_pin[0], relay_pin[1]);
+  deliveryInit();
   lcdPrintStatus(TIME_NOW_LINE0);
+  powerInit();
+  logSetClock(powerMillis); // millis() stops in standby
 }
 
 void loop()
 {
   if (bt_serial.available())
   {
+    received_ms = powerMillis(); // millis() stops in standby, trace stamps must not
     received_str = bt_serial.readStringUntil('\n');
-    Serial.println(received_str);
+    LOG_INFO(LOG_ID_BT_RX, "rx: %s", received_str.c_str());
     parseString(); // header_module, header_item, header_value
                    // e.g. "buzzer, level, 1"
-    Serial.println("header_module: " + header_module);
-    Serial.println("header_item: " + header_item);
-    Serial.println("header_value: " + header_value);
-    //1 Blocks on Delivery
-    if (header_module.equals("delivery"))
-    {
-      //1.1 Delivery Start
-      if (header_item.equals("start"))
-      {
-        lcd.clear();
-        pinMode(buzzer_pin, LOW);
-        arrv_time = header_value.toInt();
-        lcdPrintStatus(LCDINIT);
-      }
-      //1.2 Delivery complete
-      else if (header_item.equals("end"))
-      {
-        lcdPrintStatus(DELIVERY_END_LINE3);
-        turnOnBuzzer();
-      }
-      else
-      {
-        Serial.println("error: delivery");
-        return;
-      }
-      //2 Blocks on Buzzer
-    }
-    else if (header_module.equals("buzzer"))
-    {
-      //2.1 buzzer on/off control
-      if (header_item.equals("on/off"))
-      {
-        if (header_value.equals("on"))
-        {
-          turnOnBuzzer();
-        }
-        else if (header_value.equals("off"))
-        {
-          pinMode(buzzer_pin, LOW);
-        }
-        //2.2 Buzer volume control
-      }
-      else if (header_item.equals("level"))
-      {
-        setBuzzerLevel((BuzzerLevel)header_value.toInt());
-        // parsing error, "buzzer"
-      }
-      else
-      {
-        Serial.println("error: buzzer on/off");
-      }
-      //3. Blocks on Buzzer
-    }
-    else if (header_module.equals("motion"))
-    {
-      lcdPrintStatus(MOTION_LINE2);
-    }
-    else if (header_module.equals("standby"))
-    {
-      pinMode(buzzer_pin, LOW);
-      lcd.clear();
-      lcdPrintStatus(TIME_NOW_LINE0);
-    }
+    LOG_DEBUG(LOG_ID_COMMAND, "cmd: %s|%s|%s",
+              header_module.c_str(), header_item.c_str(), header_value.c_str());
+    dispatchCommand();
     // Bluetooth Connection Error
   }
   else
   {
-    Serial.println("bluetooth error");
+    LOG_DEBUG(LOG_ID_BT_IDLE, "bluetooth: no data");
+  }
+  if (powerTickPending())
+  {
+    updateTime();
   }
-  updateTime();
-}
\ No newline at end of file
+  logFlush();
+
+  // sleep until the next byte, tick or buzzer step
+  noInterrupts();
+  if (!bt_serial.available())
+  {
+    powerSleep(buzzerIsTimed());
+  }
+  interrupts();
+}
@@ -0,0 +1,126 @@
+#include "power.h"
+
+#if defined(__AVR__)
+#include <avr/power.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+static_assert(POWER_TICK_MS == 1000, "watchdog prescaler below is set for 1 s");
+#endif
+
+/**************************global variables***********************************/
+static volatile bool power_tick = false;
+static volatile uint32_t power_ticks = 0;       // watchdog ticks since power-on
+static volatile uint32_t power_tick_millis = 0; // millis() at the last tick
+static uint32_t power_start_ms = 0;             // millis() at powerInit()
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+void powerTick(void)
+{
+  power_ticks++;
+  power_tick_millis = millis();
+  power_tick = true;
+}
+
+bool powerTickPending(void)
+{
+  if (!power_tick)
+  {
+    return false;
+  }
+  power_tick = false;
+  return true;
+}
+
+uint32_t powerMillis(void)
+{
+  noInterrupts();
+  uint32_t ticks = power_ticks;
+  uint32_t awake = millis() - power_tick_millis;
+  interrupts();
+
+  // millis() and the watchdog oscillator drift apart, never pass the next tick
+  if (awake >= POWER_TICK_MS)
+  {
+    awake = POWER_TICK_MS - 1;
+  }
+  return power_start_ms + ticks * POWER_TICK_MS + awake;
+}
+
+// the watchdog starts now, powerMillis() carries on from millis()
+static void powerClockStart(void)
+{
+  noInterrupts();
+  power_start_ms = millis();
+  power_tick_millis = power_start_ms;
+  power_ticks = 0;
+  interrupts();
+}
+
+void powerSleep(bool keep_timers)
+{
+  if (power_tick)
+  {
+    interrupts();
+    return;
+  }
+  powerSleepCpu(keep_timers);
+}
+
+#if defined(__AVR__)
+ISR(WDT_vect)
+{
+  powerTick();
+}
+
+// bytes still queued, or the last one still in the shift register
+static bool powerUartBusy(void)
+{
+  return Serial.availableForWrite() < SERIAL_TX_BUFFER_SIZE - 1 || bit_is_clear(UCSR0A, TXC0);
+}
+
+void powerInit(void)
+{
+  // peripherals the module never uses
+  powerClockStart();
+  ADCSRA = 0; // the ADC has to be off before its clock is cut
+  power_adc_disable();
+  power_spi_disable();
+  power_timer2_disable();
+
+  // watchdog in interrupt mode only, it never resets the board
+  noInterrupts();
+  MCUSR &= ~_BV(WDRF);
+  wdt_reset();
+  WDTCSR = _BV(WDCE) | _BV(WDE);
+  WDTCSR = _BV(WDIE) | _BV(WDP2) | _BV(WDP1); // 1 s
+  interrupts();
+}
+
+void powerSleepCpu(bool keep_timers)
+{
+  // Timer1 and the UART stop in standby
+  set_sleep_mode((keep_timers || powerUartBusy()) ? SLEEP_MODE_IDLE : SLEEP_MODE_STANDBY);
+  sleep_enable();
+  sleep_bod_disable();
+  interrupts(); // the instruction after sei always runs, no wake-up is missed
+  sleep_cpu();
+  sleep_disable();
+}
+#else
+// host build: nothing to power down, the caller drives powerTick()
+void powerInit(void)
+{
+  powerClockStart();
+}
+
+#if !defined(POWER_SIM)
+void powerSleepCpu(bool keep_timers)
+{
+  (void)keep_timers;
+  interrupts();
+}
+#endif
+#endif
+/*****************************************************************************/
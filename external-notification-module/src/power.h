@@ -0,0 +1,37 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+/**************************Low Power Idle*************************************/
+// loop() sleeps whenever it has nothing to do. Wake-up sources:
+//  - a pin change on bt_rx_pin, i.e. SoftwareSerial's own receive interrupt
+//  - the watchdog, every POWER_TICK_MS, for the clock on the LCD
+//  - Timer1 (buzzer) and the UART, which keep the CPU in idle mode while busy
+// Otherwise the CPU sleeps in standby: like power-down, but the resonator
+// keeps running, so it wakes within 6 cycles and SoftwareSerial catches the
+// start bit of the first byte. Power-down would need 16K cycles (1 ms) to
+// restart the oscillator and lose that byte at 9600 baud.
+// millis() stands still during standby, wall time comes from the RTC and
+// intervals from powerMillis(), which the watchdog keeps counting.
+// The host build has no sleep: powerSleepCpu() is a stub unless built with
+// POWER_SIM, then sim/fakes/power_host.cpp models it, and the simulation
+// calls powerTick() from its own clock.
+
+#define POWER_TICK_MS 1000
+
+void powerInit(void);
+bool powerTickPending(void); // true once per tick, clears it
+// milliseconds since power-on that keep counting in standby from
+// powerInit() on, to within a tick and the watchdog's accuracy
+uint32_t powerMillis(void);
+// sleeps until the next interrupt, call with interrupts disabled after
+// checking for pending input; returns with interrupts enabled
+void powerSleep(bool keep_timers);
+void powerTick(void); // the watchdog interrupt
+
+// the sleep instruction itself, behind powerSleep()
+void powerSleepCpu(bool keep_timers);
+/*****************************************************************************/
+
+#endif
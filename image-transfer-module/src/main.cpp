@@ -7,9 +7,44 @@
 
 #include "esp_camera.h"
 #include "Base64.h"
+#include <Log.h>
 
 #include "private_info.h" //Wifi ssid, pwd, api-key, project-url
 #include "device_info.h"  //camera fin, camera model, etc
+
+// upload each motion event's stage times to /<location>/evtdata/<eid> for
+// tools/trace-analyzer; one more write per event and nothing prunes the
+// records, so only for test builds: -D TRACE_UPLOAD_ENABLED=1
+#ifndef TRACE_UPLOAD_ENABLED
+#define TRACE_UPLOAD_ENABLED 0
+#endif
+/**************************typedef *******************************************/
+typedef enum _ELogId // rate limiter id per message source
+{
+  LOG_ID_CAMERA,
+  LOG_ID_SENSOR,
+  LOG_ID_FIREBASE,
+  LOG_ID_SIGNAL,
+  LOG_ID_PHOTO,
+  LOG_ID_MOTION
+} LogId;
+
+typedef enum _ETraceStage // one motion event, see tools/trace-analyzer
+{
+  TRACE_MOTION,
+  TRACE_CAPTURE,
+  TRACE_ENCODE,
+  TRACE_UPLOAD_ACK,
+  TRACE_STAGES
+} TraceStage;
+
+typedef struct _STraceEvent
+{
+  char eid[9];                     // 8 hex digits, "-" before the first motion
+  uint32_t stage_ms[TRACE_STAGES]; // millis() when each stage was reached
+} TraceEvent;
+/*****************************************************************************/
+
 /**************************global variables***********************************/
 String device_location = ""; // Device Location config
 String database_path = "";   // Firebase database path
@@ -17,6 +52,7 @@ String photo_path = "";
 String signal_path = "";
 String photo_data = "";
 String sensor_control_path = "";
+String event_path = "";
 
 /*Data Objects*/
 FirebaseData firebase_data;     // Firebase Realtime Database Object
@@ -31,6 +67,9 @@ boolean is_authenticated = false; // Store device authentication status
 boolean is_motion_detected = false;
 boolean is_light_detected = false;
 int idx = 0;
+
+TraceEvent trace_event = {"-", {0}};
+const char *const trace_stage_name[TRACE_STAGES] = {"motion", "capture", "encode", "upload_ack"};
 /*****************************************************************************/
 
 /**************************pin number ****************************************/
@@ -39,6 +78,21 @@ const int builtin_led = BUILTIN_LED;
 /*****************************************************************************/
 
 /***************user-defined function*****************************************/
+//event tracing
+void traceBegin(void)
+{
+  snprintf(trace_event.eid, sizeof(trace_event.eid), "%08x", (unsigned)esp_random());
+  memset(trace_event.stage_ms, 0, sizeof(trace_event.stage_ms));
+}
+
+void traceMark(TraceStage stage)
+{
+  trace_event.stage_ms[stage] = millis();
+#if LOG_TRACE_ENABLED
+  logTrace(trace_event.eid, trace_stage_name[stage], trace_event.stage_ms[stage]);
+#endif
+}
+
 //camera instruction
 void photo2Base64(camera_fb_t *cam_fb)
 {
@@ -87,7 +141,7 @@ bool cameraInit(void)
   esp_err_t err = esp_camera_init(&cam_config);
   if (err != ESP_OK)
   {
-    Serial.printf("cameraInit() failed with error 0x%x", err);
+    LOG_ERROR(LOG_ID_CAMERA, "cameraInit() failed with error 0x%x", err);
     return false;
   }
   sensor_t *s = esp_camera_sensor_get();
@@ -98,16 +152,13 @@ bool cameraInit(void)
 void wifiInit(void)
 {
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  Serial.print("Connecting to Wi-Fi");
+  LOG_INFO(LOG_ID_NONE, "Connecting to Wi-Fi");
+  logFlushAll();
   while (WiFi.status() != WL_CONNECTED)
   {
-    Serial.print(".");
     delay(300);
   }
-  Serial.println();
-  Serial.print("Connected with IP: ");
-  Serial.println(WiFi.localIP());
-  Serial.println();
+  LOG_INFO(LOG_ID_NONE, "Connected with IP: %s", WiFi.localIP().toString().c_str());
 }
 
 // for Firebase initialization, use Firebase API
@@ -117,18 +168,17 @@ void firebaseInit()
   firebase_config.database_url = DATABASE_URL; // configure firebase realtime database url
   Firebase.reconnectWiFi(true);                // Enable WiFi reconnection
 
-  Serial.println("------------------------------------");
-  Serial.println("Connecting to Firebase...");
+  LOG_INFO(LOG_ID_NONE, "Connecting to Firebase...");
 
   if (Firebase.signUp(&firebase_config, &firebase_auth, "", ""))
   { // Sign in to firebase
-    Serial.println("Success");
+    LOG_INFO(LOG_ID_NONE, "Success");
     is_authenticated = true;
     fuid = firebase_auth.token.uid.c_str();
   }
   else
   {
-    Serial.printf("Failed, %s\n", firebase_config.signer.signupError.message.c_str());
+    LOG_ERROR(LOG_ID_NONE, "Failed, %s", firebase_config.signer.signupError.message.c_str());
     is_authenticated = false;
   }
   firebase_config.token_status_callback = tokenStatusCallback; // Assign the callback function for the long running token generation task, see addons/TokenHelper.h
@@ -139,54 +189,81 @@ void sendMotionSignalToFirebase(boolean signal)
 {
   if (is_authenticated && Firebase.ready())
   {
-    if (Firebase.set(firebase_data, signal_path.c_str(), (int)signal))
+    bool is_sent;
+    if (signal)
     {
-      Serial.println("PASSED");
-      Serial.println("PATH: " + firebase_data.dataPath());
-      Serial.println("TYPE: " + firebase_data.dataType());
-      Serial.println("ETag: " + firebase_data.ETag());
-      Serial.print("VALUE: ");
-      printResult(firebase_data); //see addons/RTDBHelper.h
-      Serial.println("------------------------------------");
-      Serial.println();
+      // sgndata and the event id in one request, the app can forward evtid
+      FirebaseJson json;
+      json.set("sgndata", 1);
+      json.set("evtid", trace_event.eid);
+      is_sent = Firebase.updateNode(firebase_data, database_path.c_str(), json);
     }
     else
     {
-      Serial.println("FAILED");
-      Serial.println("REASON: " + firebase_data.errorReason());
-      Serial.println("------------------------------------");
-      Serial.println();
+      is_sent = Firebase.set(firebase_data, signal_path.c_str(), 0);
+    }
+
+    if (is_sent)
+    {
+      LOG_DEBUG(LOG_ID_SIGNAL, "signal PASSED path: %s type: %s etag: %s",
+                firebase_data.dataPath().c_str(), firebase_data.dataType().c_str(),
+                firebase_data.ETag().c_str());
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+      printResult(firebase_data); //see addons/RTDBHelper.h, writes to Serial directly
+#endif
+    }
+    else
+    {
+      LOG_ERROR(LOG_ID_SIGNAL, "signal FAILED reason: %s", firebase_data.errorReason().c_str());
     }
   }
 }
 
+#if TRACE_UPLOAD_ENABLED
+// stage times of the current event, the camera is rarely on a serial cable
+void sendTraceEventToFirebase(void)
+{
+  FirebaseJson json;
+  for (int i = 0; i < TRACE_STAGES; i++)
+  {
+    json.set(trace_stage_name[i], (int)trace_event.stage_ms[i]); // wraps after 24 days
+  }
+  json.set("srv/.sv", "timestamp"); // server time of the write
+  if (!Firebase.setJSON(firebase_data, (event_path + "/" + trace_event.eid).c_str(), json))
+  {
+    LOG_ERROR(LOG_ID_FIREBASE, "event %s FAILED reason: %s", trace_event.eid,
+              firebase_data.errorReason().c_str());
+  }
+}
+#endif
+
 void getPhotoThenSendToFirebase(void)
 {
   camera_fb_t *cam_fb = NULL;
   cam_fb = esp_camera_fb_get();
+  traceMark(TRACE_CAPTURE);
 
   photo2Base64(cam_fb);
+  traceMark(TRACE_ENCODE);
 
   if (is_authenticated && Firebase.ready())
   {
     if (Firebase.setString(firebase_data, photo_path.c_str(), photo_data))
     {
-      Serial.println("PASSED");
-      Serial.println("PATH: " + firebase_data.dataPath());
-      Serial.println("TYPE: " + firebase_data.dataType());
-      Serial.println("ETag: " + firebase_data.ETag());
-      Serial.print("VALUE: ");
-      Serial.println("complete");
-      printResult(firebase_data); //see addons/RTDBHelper.h
-      Serial.println("------------------------------------");
-      Serial.println();
+      traceMark(TRACE_UPLOAD_ACK);
+      LOG_INFO(LOG_ID_PHOTO, "photo PASSED path: %s type: %s etag: %s",
+               firebase_data.dataPath().c_str(), firebase_data.dataType().c_str(),
+               firebase_data.ETag().c_str());
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+      printResult(firebase_data); //see addons/RTDBHelper.h, writes to Serial directly
+#endif
+#if TRACE_UPLOAD_ENABLED
+      sendTraceEventToFirebase();
+#endif
     }
     else
     {
-      Serial.println("FAILED");
-      Serial.println("REASON: " + firebase_data.errorReason());
-      Serial.println("------------------------------------");
-      Serial.println();
+      LOG_ERROR(LOG_ID_PHOTO, "photo FAILED reason: %s", firebase_data.errorReason().c_str());
     }
   }
 
@@ -205,22 +282,13 @@ void getPhotoThenSendToFirebaseWithIndex(int idx)
   {
     if (Firebase.setString(firebase_data, (photo_path + "_" + String(idx)).c_str(), photo_data))
     {
-      Serial.println("PASSED");
-      Serial.println("PATH: " + firebase_data.dataPath());
-      Serial.println("TYPE: " + firebase_data.dataType());
-      Serial.println("ETag: " + firebase_data.ETag());
-      Serial.print("VALUE: ");
-      Serial.println("complete");
-      //printResult(firebase_data); //see addons/RTDBHelper.h
-      Serial.println("------------------------------------");
-      Serial.println();
+      LOG_INFO(LOG_ID_PHOTO, "photo_%d PASSED path: %s type: %s etag: %s", idx,
+               firebase_data.dataPath().c_str(), firebase_data.dataType().c_str(),
+               firebase_data.ETag().c_str());
     }
     else
     {
-      Serial.println("FAILED");
-      Serial.println("REASON: " + firebase_data.errorReason());
-      Serial.println("------------------------------------");
-      Serial.println();
+      LOG_ERROR(LOG_ID_PHOTO, "photo_%d FAILED reason: %s", idx, firebase_data.errorReason().c_str());
     }
   }
 
@@ -232,10 +300,12 @@ void getPhotoThenSendToFirebaseWithIndex(int idx)
 void setup()
 {
   Serial.begin(115200);                  // Initialize serial port for diagnosis
+  logBegin(&Serial);                     // buffered, drained by logFlush() in loop()
   database_path = "/" + device_location; // Set the database path where updates will be loaded for this device
   photo_path = database_path + "/imgdata";
   signal_path = database_path + "/sgndata";
   sensor_control_path = database_path + "/sensor_control";
+  event_path = database_path + "/evtdata";
 
   // Set pinmode
   pinMode(motion_pin, INPUT);
@@ -244,6 +314,7 @@ void setup()
   wifiInit();     // Initialize Connection with location WiFi
   firebaseInit(); // Initialise firebase configuration and signup anonymously
   cameraInit();   // Initialise OV2640 camera module
+  logFlushAll();
 }
 
 void loop()
@@ -253,12 +324,17 @@ void loop()
     sensor_control = firebase_data.stringData();
     if (sensor_control.equals("true"))
     {
-      Serial.println("sensor on");
+      LOG_DEBUG(LOG_ID_SENSOR, "sensor on");
       is_motion_detected = digitalRead(motion_pin);
+      if (is_motion_detected)
+      {
+        traceBegin();
+        traceMark(TRACE_MOTION);
+      }
       sendMotionSignalToFirebase(is_motion_detected);
       if (is_motion_detected)
       {
-        Serial.println("motion detected");
+        LOG_INFO(LOG_ID_MOTION, "motion detected");
         digitalWrite(builtin_led, HIGH);
         getPhotoThenSendToFirebase();
         digitalWrite(builtin_led, LOW);
@@ -269,7 +345,8 @@ void loop()
   }
   else
   {
-    Serial.println("error: firebase");
+    LOG_ERROR(LOG_ID_FIREBASE, "error: firebase");
   }
+  logFlush();
 }
 /*}***************************************************************************/
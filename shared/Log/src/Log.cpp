@@ -0,0 +1,227 @@
+#include "Log.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#if defined(__AVR__)
+#define LOG_VSNPRINTF vsnprintf_P
+#define LOG_SNPRINTF snprintf_P
+#define LOG_FMT_PSTR "%S" // avr-libc: argument is a string in flash
+#else
+#define LOG_VSNPRINTF vsnprintf
+#define LOG_SNPRINTF snprintf
+#define LOG_FMT_PSTR "%s"
+#endif
+
+/**************************global variables***********************************/
+static Print *log_out = NULL;
+static uint32_t (*log_clock)(void) = NULL; // rate limiter time, NULL: millis()
+
+static char log_ring[LOG_RING_SIZE];
+static uint16_t log_tail = 0; // oldest unsent byte
+static uint16_t log_used = 0; // bytes waiting in the ring
+
+static uint16_t log_dropped = 0;            // total, saturating
+static uint16_t log_dropped_unreported = 0; // not yet announced on the output
+
+static uint32_t log_rate_last[LOG_RATE_SLOTS];
+static uint8_t log_rate_suppressed[LOG_RATE_SLOTS];
+static bool log_rate_seen[LOG_RATE_SLOTS];
+
+static const char log_level_tag[] = "-EWID"; // indexed by LOG_LEVEL_*
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static void logCountDropped(void)
+{
+  if (log_dropped < 0xFFFF)
+  {
+    log_dropped++;
+  }
+  if (log_dropped_unreported < 0xFFFF)
+  {
+    log_dropped_unreported++;
+  }
+}
+
+// copies a whole line into the ring or nothing at all
+static bool logPush(const char *str, uint16_t len)
+{
+  if (len > LOG_RING_SIZE - log_used)
+  {
+    return false;
+  }
+
+  uint16_t head = log_tail + log_used;
+  if (head >= LOG_RING_SIZE)
+  {
+    head -= LOG_RING_SIZE;
+  }
+  for (uint16_t i = 0; i < len; i++)
+  {
+    log_ring[head++] = str[i];
+    if (head == LOG_RING_SIZE)
+    {
+      head = 0;
+    }
+  }
+  log_used += len;
+  return true;
+}
+
+// false if the id already logged within LOG_RATE_MS,
+// otherwise *suppressed is the number of lines dropped since the last one
+static bool logRateAllow(uint8_t id, uint8_t *suppressed)
+{
+  *suppressed = 0;
+  if (id == LOG_ID_NONE)
+  {
+    return true;
+  }
+
+  uint8_t slot = id % LOG_RATE_SLOTS;
+  uint32_t now = (log_clock != NULL) ? log_clock() : millis();
+  if (log_rate_seen[slot] && now - log_rate_last[slot] < LOG_RATE_MS)
+  {
+    if (log_rate_suppressed[slot] < 0xFF)
+    {
+      log_rate_suppressed[slot]++;
+    }
+    return false;
+  }
+
+  log_rate_seen[slot] = true;
+  log_rate_last[slot] = now;
+  *suppressed = log_rate_suppressed[slot];
+  log_rate_suppressed[slot] = 0;
+  return true;
+}
+
+static uint16_t logClamp(int len, uint16_t pos, uint16_t cap)
+{
+  if (len < 0)
+  {
+    return pos;
+  }
+  return (pos + len > cap) ? cap : pos + len;
+}
+
+void logBegin(Print *out)
+{
+  log_out = out;
+}
+
+void logSetClock(uint32_t (*now_ms)(void))
+{
+  log_clock = now_ms;
+}
+
+void logWrite(uint8_t level, uint8_t id, const char *fmt_P, ...)
+{
+  const uint16_t cap = LOG_LINE_MAX - 2; // keep room for "\r\n"
+  char line[LOG_LINE_MAX + 1];
+  uint16_t pos = 0;
+  uint8_t suppressed;
+  va_list args;
+
+  if (!logRateAllow(id, &suppressed))
+  {
+    return;
+  }
+
+  line[pos++] = log_level_tag[level <= LOG_LEVEL_DEBUG ? level : 0];
+  line[pos++] = ' ';
+
+  va_start(args, fmt_P);
+  pos = logClamp(LOG_VSNPRINTF(line + pos, cap - pos + 1, fmt_P, args), pos, cap);
+  va_end(args);
+
+  if (suppressed > 0)
+  {
+    pos = logClamp(LOG_SNPRINTF(line + pos, cap - pos + 1, PSTR(" (+%u)"), suppressed), pos, cap);
+  }
+  line[pos++] = '\r';
+  line[pos++] = '\n';
+
+  if (!logPush(line, pos))
+  {
+    logCountDropped();
+  }
+}
+
+void logTrace(const char *eid, const char *stage_P, uint32_t ms)
+{
+  char line[LOG_LINE_MAX + 1];
+  int len = LOG_SNPRINTF(line, sizeof(line), PSTR("T %s " LOG_FMT_PSTR " %lu\r\n"),
+                         eid, stage_P, (unsigned long)ms);
+
+  // a cut record would be misread, drop it whole
+  if (len < 0 || len >= (int)sizeof(line) || !logPush(line, len))
+  {
+    logCountDropped();
+  }
+}
+
+void logFlush(void)
+{
+  if (log_out == NULL)
+  {
+    return;
+  }
+
+  int room = log_out->availableForWrite();
+  while (room > 0 && log_used > 0)
+  {
+    uint16_t chunk = (log_tail + log_used > LOG_RING_SIZE) ? LOG_RING_SIZE - log_tail : log_used;
+    if (chunk > room)
+    {
+      chunk = room;
+    }
+    log_out->write((const uint8_t *)&log_ring[log_tail], chunk);
+    log_tail += chunk;
+    if (log_tail == LOG_RING_SIZE)
+    {
+      log_tail = 0;
+    }
+    log_used -= chunk;
+    room -= chunk;
+  }
+
+  if (log_dropped_unreported > 0)
+  {
+    char line[24];
+    int len = LOG_SNPRINTF(line, sizeof(line), PSTR("W log: %u dropped\r\n"), log_dropped_unreported);
+    if (len > 0 && len < (int)sizeof(line) && logPush(line, len))
+    {
+      log_dropped_unreported = 0;
+    }
+  }
+}
+
+void logFlushAll(void)
+{
+  if (log_out == NULL)
+  {
+    return;
+  }
+
+  do
+  {
+    while (log_used > 0)
+    {
+      log_out->write((uint8_t)log_ring[log_tail]);
+      if (++log_tail == LOG_RING_SIZE)
+      {
+        log_tail = 0;
+      }
+      log_used--;
+    }
+    logFlush(); // queues the drop report, if any
+  } while (log_used > 0);
+}
+
+uint16_t logDropped(void)
+{
+  return log_dropped;
+}
+/*****************************************************************************/
@@ -0,0 +1,101 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+/**************************Logging*********************************************/
+// Shared by the notification (Uno) and image transfer (ESP32-CAM) firmwares.
+//  - levels above LOG_LEVEL compile to nothing, arguments are not evaluated
+//  - messages are formatted into a fixed ring buffer, logFlush() moves only
+//    as many bytes as the serial TX buffer can take, so it never blocks
+//  - each message id is rate limited to one line per LOG_RATE_MS, messages
+//    dropped by the limiter or by a full ring are counted and reported; the
+//    limiter runs on millis() unless logSetClock() gives it a clock that
+//    keeps counting while the board sleeps
+// Not for use inside interrupt handlers.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// override from build_flags, e.g. -D LOG_LEVEL=LOG_LEVEL_DEBUG
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if defined(__AVR__)
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 128 // bytes, on top of the 64 byte serial TX buffer
+#endif
+#ifndef LOG_LINE_MAX
+#define LOG_LINE_MAX 48 // longest formatted line, longer lines are cut
+#endif
+#else
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 2048
+#endif
+#ifndef LOG_LINE_MAX
+#define LOG_LINE_MAX 160
+#endif
+#endif
+
+// rate limiter slots, ids are folded into them with id % LOG_RATE_SLOTS
+#ifndef LOG_RATE_SLOTS
+#define LOG_RATE_SLOTS 8
+#endif
+// minimum interval between two lines with the same id
+#ifndef LOG_RATE_MS
+#define LOG_RATE_MS 1000
+#endif
+
+// id for messages that must never be rate limited
+#define LOG_ID_NONE 0xFF
+
+// trace records for end-to-end latency, "T <eid> <stage> <ms>": independent
+// of LOG_LEVEL and never rate limited, tools/trace-analyzer joins them
+#ifndef LOG_TRACE_ENABLED
+#define LOG_TRACE_ENABLED 1
+#endif
+
+void logBegin(Print *out);
+void logSetClock(uint32_t (*now_ms)(void)); // NULL: millis()
+void logWrite(uint8_t level, uint8_t id, const char *fmt_P, ...);
+void logTrace(const char *eid, const char *stage_P, uint32_t ms);
+void logFlush(void);    // non-blocking, call once per loop()
+void logFlushAll(void); // blocking, for setup() only
+uint16_t logDropped(void);
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(id, fmt, ...) logWrite(LOG_LEVEL_ERROR, (id), PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(id, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(id, fmt, ...) logWrite(LOG_LEVEL_WARN, (id), PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_WARN(id, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(id, fmt, ...) logWrite(LOG_LEVEL_INFO, (id), PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_INFO(id, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(id, fmt, ...) logWrite(LOG_LEVEL_DEBUG, (id), PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(id, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_TRACE_ENABLED
+#define LOG_TRACE(eid, stage, ms) logTrace((eid), PSTR(stage), (ms))
+#else
+#define LOG_TRACE(eid, stage, ms) do {} while (0)
+#endif
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,418 @@
+/**************************Fleet simulator*************************************/
+// Runs many virtual cameras (src/virtual_camera.h) against a local mock of
+// the Realtime Database (src/mock_rtdb.h) and reports the load per device:
+// requests/s, bytes/s and latency percentiles, per request kind and device.
+//
+//   program [options], see fleetUsage()
+//
+// Devices are spread over a pool of threads. Each thread runs the pass of
+// whichever of its devices is due next; a device's pass is blocking, so a
+// thread that cannot keep up shows as schedule lag in the report.
+/*****************************************************************************/
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mock_rtdb.h"
+#include "virtual_camera.h"
+
+/**************************typedef *******************************************/
+typedef struct _SFleetOptions
+{
+  FleetConfig config;
+  unsigned devices;
+  unsigned threads;
+  double seconds;
+  double sensor_on;   // share of devices whose sensor_control is "true"
+  uint16_t port;      // of the mock, 0 picks a free one
+  bool serve_only;    // run the mock database alone
+  std::string csv_path;
+} FleetOptions;
+
+typedef std::pair<FleetClock::time_point, size_t> FleetDue; // next pass, device
+/*****************************************************************************/
+
+/**************************global variables***********************************/
+static const char *const request_name[REQ_KINDS] = {"GET sensor_control", "PUT sgndata",
+                                                    "PATCH sgndata+evtid", "PUT imgdata",
+                                                    "PUT evtdata"};
+static volatile sig_atomic_t fleet_stop = 0;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static void fleetUsage(void)
+{
+  std::cerr << "usage: program [options]\n"
+               "  -d N            virtual cameras (200)\n"
+               "  -t N            threads (32)\n"
+               "  -s SECONDS      run time (30)\n"
+               "  --motion N      PIR events per device and minute (0.5)\n"
+               "  --image BYTES   JPEG size before Base64 (12000)\n"
+               "  --jitter BYTES  +- uniform around --image (4000)\n"
+               "  --pass-ms N     delay at the end of a pass, delay(100) (100)\n"
+               "  --cooldown-ms N delay after a photo, delay(10000) (10000)\n"
+               "  --sensor-on F   share of devices with sensor_control \"true\" (1.0)\n"
+               "  --on-change     write sgndata only when it changes\n"
+               "  --no-keepalive  new connection per request\n"
+               "  --silent        ?print=silent on writes, no echo\n"
+               "  --trace-upload  PUT evtdata/<eid> after each photo\n"
+               "  --csv FILE      per-device table\n"
+               "  --port N        mock database port (0: any free one)\n"
+               "  --serve         only run the mock database, until Ctrl-C\n";
+}
+
+static bool fleetParseArgs(int argc, char **argv, FleetOptions *options)
+{
+  FleetConfig *config = &options->config;
+  config->motion_per_min = 0.5;
+  config->image_bytes = 12000;
+  config->image_jitter = 4000;
+  config->pass_delay_ms = 100;
+  config->cooldown_ms = 10000;
+  config->signal_on_change = false;
+  config->keep_alive = true;
+  config->silent = false;
+  config->trace_upload = false;
+  options->devices = 200;
+  options->threads = 32;
+  options->seconds = 30;
+  options->sensor_on = 1.0;
+  options->port = 0;
+  options->serve_only = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "-d" && has_value)
+    {
+      options->devices = (unsigned)strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "-t" && has_value)
+    {
+      options->threads = (unsigned)strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "-s" && has_value)
+    {
+      options->seconds = strtod(argv[++i], NULL);
+    }
+    else if (arg == "--motion" && has_value)
+    {
+      config->motion_per_min = strtod(argv[++i], NULL);
+    }
+    else if (arg == "--image" && has_value)
+    {
+      config->image_bytes = (uint32_t)strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--jitter" && has_value)
+    {
+      config->image_jitter = (uint32_t)strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--pass-ms" && has_value)
+    {
+      config->pass_delay_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--cooldown-ms" && has_value)
+    {
+      config->cooldown_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--sensor-on" && has_value)
+    {
+      options->sensor_on = strtod(argv[++i], NULL);
+    }
+    else if (arg == "--on-change")
+    {
+      config->signal_on_change = true;
+    }
+    else if (arg == "--no-keepalive")
+    {
+      config->keep_alive = false;
+    }
+    else if (arg == "--silent")
+    {
+      config->silent = true;
+    }
+    else if (arg == "--trace-upload")
+    {
+      config->trace_upload = true;
+    }
+    else if (arg == "--csv" && has_value)
+    {
+      options->csv_path = argv[++i];
+    }
+    else if (arg == "--port" && has_value)
+    {
+      options->port = (uint16_t)strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--serve")
+    {
+      options->serve_only = true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return options->devices > 0 && options->threads > 0 && options->seconds > 0 &&
+         config->image_jitter <= config->image_bytes;
+}
+
+static void fleetOnSignal(int)
+{
+  fleet_stop = 1;
+}
+
+// each thread owns devices thread, thread + threads, ... and runs the one
+// due first; a device leaves once its next pass would start after the end
+static void fleetWorker(std::vector<VirtualCamera *> *cameras, unsigned first, unsigned step,
+                        FleetClock::time_point start, FleetClock::time_point end)
+{
+  std::priority_queue<FleetDue, std::vector<FleetDue>, std::greater<FleetDue>> due;
+  for (size_t i = first; i < cameras->size(); i += step)
+  {
+    // power-on spread over the first second
+    due.push(FleetDue(start + std::chrono::microseconds(1000000 * i / cameras->size()), i));
+  }
+
+  while (!due.empty() && !fleet_stop)
+  {
+    FleetDue next = due.top();
+    due.pop();
+    if (next.first >= end)
+    {
+      continue;
+    }
+    std::this_thread::sleep_until(next.first);
+    due.push(FleetDue((*cameras)[next.second]->runPass(next.first), next.second));
+  }
+}
+
+static uint32_t fleetPercentile(std::vector<uint32_t> *values, double p)
+{
+  if (values->empty())
+  {
+    return 0;
+  }
+  size_t idx = (size_t)(p * (values->size() - 1) + 0.5);
+  std::nth_element(values->begin(), values->begin() + idx, values->end());
+  return (*values)[idx];
+}
+
+static double fleetPercentile(std::vector<double> values, double p)
+{
+  if (values.empty())
+  {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[(size_t)(p * (values.size() - 1) + 0.5)];
+}
+
+static void fleetPrintDistribution(const char *name, const std::vector<double> &values)
+{
+  printf("  %-22s %10.1f %10.1f %10.1f %10.1f\n", name, fleetPercentile(values, 0.0),
+         fleetPercentile(values, 0.5), fleetPercentile(values, 0.99), fleetPercentile(values, 1.0));
+}
+
+int main(int argc, char **argv)
+{
+  FleetOptions options;
+  if (!fleetParseArgs(argc, argv, &options))
+  {
+    fleetUsage();
+    return 2;
+  }
+  signal(SIGINT, fleetOnSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  MockRtdb rtdb;
+  if (!rtdb.start(options.port))
+  {
+    perror("mock database");
+    return 2;
+  }
+  options.config.port = rtdb.port();
+
+  std::mt19937 rng(1);
+  for (unsigned i = 0; i < options.devices; i++)
+  {
+    char path[48];
+    snprintf(path, sizeof(path), "/cam%03u/sensor_control", i);
+    bool is_on = std::uniform_real_distribution<double>(0.0, 1.0)(rng) < options.sensor_on;
+    rtdb.put(path, is_on ? "\"true\"" : "\"false\"");
+  }
+
+  if (options.serve_only)
+  {
+    printf("mock database on 127.0.0.1:%u, sensor_control seeded for cam000..cam%03u\n",
+           options.config.port, options.devices - 1);
+    fflush(stdout);
+    while (!fleet_stop)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    MockRtdbStats served = rtdb.stats();
+    printf("\n%llu requests, %llu bytes in, %llu bytes out\n", (unsigned long long)served.requests,
+           (unsigned long long)served.bytes_in, (unsigned long long)served.bytes_out);
+    return 0;
+  }
+
+  // one photo's worth of Base64 digits, shared by all devices
+  uint32_t largest = options.config.image_bytes + options.config.image_jitter;
+  std::string image_pool((largest + 2) / 3 * 4 + 4, 'A');
+  static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  for (size_t i = 0; i < image_pool.length(); i++)
+  {
+    image_pool[i] = digits[rng() & 63];
+  }
+
+  std::vector<VirtualCamera *> cameras;
+  for (unsigned i = 0; i < options.devices; i++)
+  {
+    cameras.push_back(new VirtualCamera(&options.config, i, &image_pool));
+  }
+
+  unsigned threads = std::min(options.threads, options.devices);
+  FleetClock::time_point start = FleetClock::now();
+  FleetClock::time_point end = start + std::chrono::microseconds((int64_t)(options.seconds * 1e6));
+  std::vector<std::thread> pool;
+  for (unsigned i = 0; i < threads; i++)
+  {
+    pool.push_back(std::thread(fleetWorker, &cameras, i, threads, start, end));
+  }
+  for (size_t i = 0; i < pool.size(); i++)
+  {
+    pool[i].join();
+  }
+  double run_s = std::chrono::duration<double>(FleetClock::now() - start).count();
+  MockRtdbStats served = rtdb.stats();
+  rtdb.stop();
+
+  /* report */
+  const double mb = 1024.0 * 1024.0;
+  printf("%u devices on %u threads, %.1f s, motion %.2f/min, photo %u+-%u bytes, signal %s, %s%s\n",
+         options.devices, threads, run_s, options.config.motion_per_min, options.config.image_bytes,
+         options.config.image_jitter, options.config.signal_on_change ? "on change" : "every pass",
+         options.config.keep_alive ? "keep-alive" : "connection per request",
+         options.config.silent ? ", print=silent" : "");
+  printf("mock database: %llu requests, %llu connections, %.1f MB in, %.1f MB out\n",
+         (unsigned long long)served.requests, (unsigned long long)served.connections,
+         served.bytes_in / mb, served.bytes_out / mb);
+
+  printf("\nrequest                     n    req/s   MB/s up MB/s down   p50 ms   p99 ms   max ms\n");
+  uint64_t total_requests = 0, total_up = 0, total_down = 0, total_errors = 0, total_motions = 0;
+  std::vector<uint32_t> total_latency;
+  for (int kind = 0; kind < REQ_KINDS; kind++)
+  {
+    uint64_t requests = 0, up = 0, down = 0;
+    std::vector<uint32_t> latency;
+    for (size_t i = 0; i < cameras.size(); i++)
+    {
+      const DeviceStats &stats = cameras[i]->stats;
+      requests += stats.requests[kind];
+      up += stats.bytes_up[kind];
+      down += stats.bytes_down[kind];
+      latency.insert(latency.end(), stats.latency_us[kind].begin(), stats.latency_us[kind].end());
+    }
+    total_requests += requests;
+    total_up += up;
+    total_down += down;
+    total_latency.insert(total_latency.end(), latency.begin(), latency.end());
+    printf("  %-20s %8llu %8.1f %9.3f %9.3f %8.2f %8.2f %8.2f\n", request_name[kind],
+           (unsigned long long)requests, requests / run_s, up / mb / run_s, down / mb / run_s,
+           fleetPercentile(&latency, 0.5) / 1e3, fleetPercentile(&latency, 0.99) / 1e3,
+           fleetPercentile(&latency, 1.0) / 1e3);
+  }
+
+  // per device
+  std::vector<double> device_rps, device_kbps, device_p99, device_lag;
+  std::vector<std::pair<uint32_t, size_t>> slowest;
+  FILE *csv = options.csv_path.empty() ? NULL : fopen(options.csv_path.c_str(), "w");
+  if (csv != NULL)
+  {
+    fprintf(csv, "device,requests,errors,motions,req_per_s,bytes_up_per_s,bytes_down_per_s,"
+                 "p50_ms,p99_ms,max_ms,lag_p99_ms\n");
+  }
+  for (size_t i = 0; i < cameras.size(); i++)
+  {
+    DeviceStats &stats = cameras[i]->stats;
+    uint64_t requests = 0, up = 0, down = 0;
+    std::vector<uint32_t> latency;
+    for (int kind = 0; kind < REQ_KINDS; kind++)
+    {
+      requests += stats.requests[kind];
+      up += stats.bytes_up[kind];
+      down += stats.bytes_down[kind];
+      latency.insert(latency.end(), stats.latency_us[kind].begin(), stats.latency_us[kind].end());
+    }
+    total_errors += stats.errors;
+    total_motions += stats.motions;
+
+    uint32_t p50 = fleetPercentile(&latency, 0.5);
+    uint32_t p99 = fleetPercentile(&latency, 0.99);
+    uint32_t max = fleetPercentile(&latency, 1.0);
+    uint32_t lag = fleetPercentile(&stats.lag_us, 0.99);
+    device_rps.push_back(requests / run_s);
+    device_kbps.push_back((up + down) / 1024.0 / run_s);
+    device_p99.push_back(p99 / 1e3);
+    device_lag.push_back(lag / 1e3);
+    slowest.push_back(std::make_pair(p99, i));
+
+    if (csv != NULL)
+    {
+      fprintf(csv, "%s,%llu,%llu,%u,%.2f,%.0f,%.0f,%.2f,%.2f,%.2f,%.2f\n", cameras[i]->location().c_str(),
+              (unsigned long long)requests, (unsigned long long)stats.errors, stats.motions,
+              requests / run_s, up / run_s, down / run_s, p50 / 1e3, p99 / 1e3, max / 1e3, lag / 1e3);
+    }
+  }
+  if (csv != NULL)
+  {
+    fclose(csv);
+  }
+
+  printf("  %-20s %8llu %8.1f %9.3f %9.3f %8.2f %8.2f %8.2f\n", "all",
+         (unsigned long long)total_requests, total_requests / run_s, total_up / mb / run_s,
+         total_down / mb / run_s, fleetPercentile(&total_latency, 0.5) / 1e3,
+         fleetPercentile(&total_latency, 0.99) / 1e3, fleetPercentile(&total_latency, 1.0) / 1e3);
+  printf("  %llu motion events, %llu failed requests\n", (unsigned long long)total_motions,
+         (unsigned long long)total_errors);
+
+  printf("\nper device                    min        p50        p99        max\n");
+  fleetPrintDistribution("req/s", device_rps);
+  fleetPrintDistribution("KB/s up+down", device_kbps);
+  fleetPrintDistribution("p99 latency ms", device_p99);
+  fleetPrintDistribution("p99 schedule lag ms", device_lag);
+
+  std::sort(slowest.rbegin(), slowest.rend());
+  printf("\nslowest devices by p99 latency\n");
+  for (size_t i = 0; i < slowest.size() && i < 5; i++)
+  {
+    const VirtualCamera *camera = cameras[slowest[i].second];
+    printf("  %-8s %8.2f ms p99  %6u motions  %llu failed\n", camera->location().c_str(),
+           slowest[i].first / 1e3, camera->stats.motions, (unsigned long long)camera->stats.errors);
+  }
+  if (fleetPercentile(device_lag, 0.5) > options.config.pass_delay_ms)
+  {
+    printf("\nmost passes started late: the threads are saturated, raise -t\n");
+  }
+
+  for (size_t i = 0; i < cameras.size(); i++)
+  {
+    delete cameras[i];
+  }
+  return total_errors ? 1 : 0;
+}
+/*****************************************************************************/
@@ -0,0 +1,498 @@
+#include "mock_rtdb.h"
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+/**************************typedef *******************************************/
+struct MockRtdb::Connection
+{
+  int fd;
+  std::string in;
+  std::string out;
+  size_t out_pos;
+  bool close_after; // "Connection: close", once out is sent
+  bool want_out;    // EPOLLOUT registered
+};
+/*****************************************************************************/
+
+/**************************global variables***********************************/
+static const size_t mock_head_max = 16 * 1024;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static void mockSetNonBlocking(int fd)
+{
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static std::string mockLower(const std::string &str)
+{
+  std::string lower(str);
+  for (size_t i = 0; i < lower.length(); i++)
+  {
+    lower[i] = (char)tolower((unsigned char)lower[i]);
+  }
+  return lower;
+}
+
+// value of a header in the lower-cased head, empty if missing
+static std::string mockHeader(const std::string &head_lower, const char *name)
+{
+  std::string key = std::string("\r\n") + name + ":";
+  std::string::size_type at = head_lower.find(key);
+  if (at == std::string::npos)
+  {
+    return "";
+  }
+  at += key.length();
+  std::string::size_type end = head_lower.find("\r\n", at);
+  std::string value = head_lower.substr(at, end == std::string::npos ? std::string::npos : end - at);
+  std::string::size_type first = value.find_first_not_of(" \t");
+  return (first == std::string::npos) ? "" : value.substr(first);
+}
+
+MockRtdb::MockRtdb(void)
+    : listen_fd(-1), epoll_fd(-1), wake_fd(-1), listen_port(0), running(false)
+{
+  memset(&counters, 0, sizeof(counters));
+}
+
+MockRtdb::~MockRtdb(void)
+{
+  stop();
+}
+
+bool MockRtdb::start(uint16_t port)
+{
+  listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd < 0)
+  {
+    return false;
+  }
+  int one = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  socklen_t addr_len = sizeof(addr);
+  if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, 1024) != 0 ||
+      getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len) != 0)
+  {
+    close(listen_fd);
+    listen_fd = -1;
+    return false;
+  }
+  listen_port = ntohs(addr.sin_port);
+  mockSetNonBlocking(listen_fd);
+
+  epoll_fd = epoll_create1(0);
+  wake_fd = eventfd(0, EFD_NONBLOCK);
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = &listen_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+  event.data.ptr = &wake_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+
+  running = true;
+  thread = std::thread(&MockRtdb::run, this);
+  return true;
+}
+
+void MockRtdb::stop(void)
+{
+  if (!running)
+  {
+    return;
+  }
+  running = false;
+  uint64_t one = 1;
+  if (write(wake_fd, &one, sizeof(one)) < 0)
+  {
+    perror("mock rtdb: wake");
+  }
+  thread.join();
+  close(wake_fd);
+  close(epoll_fd);
+  close(listen_fd);
+}
+
+void MockRtdb::put(const std::string &path, const std::string &json)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  store[path] = json;
+}
+
+MockRtdbStats MockRtdb::stats(void)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return counters;
+}
+
+void MockRtdb::run(void)
+{
+  std::vector<struct epoll_event> events(256);
+  std::map<int, Connection *> connections;
+
+  while (running)
+  {
+    int ready = epoll_wait(epoll_fd, events.data(), (int)events.size(), -1);
+    for (int i = 0; i < ready; i++)
+    {
+      void *ptr = events[i].data.ptr;
+      if (ptr == &wake_fd)
+      {
+        continue; // running is false
+      }
+      if (ptr == &listen_fd)
+      {
+        for (;;)
+        {
+          int fd = ::accept(listen_fd, NULL, NULL);
+          if (fd < 0)
+          {
+            break;
+          }
+          int one = 1;
+          setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          mockSetNonBlocking(fd);
+
+          Connection *connection = new Connection();
+          connection->fd = fd;
+          connection->out_pos = 0;
+          connection->close_after = false;
+          connection->want_out = false;
+          connections[fd] = connection;
+
+          struct epoll_event event;
+          event.events = EPOLLIN;
+          event.data.ptr = connection;
+          epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+
+          std::lock_guard<std::mutex> lock(mutex);
+          counters.connections++;
+        }
+        continue;
+      }
+
+      Connection *connection = (Connection *)ptr;
+      bool is_open = true;
+      if (events[i].events & (EPOLLERR | EPOLLHUP))
+      {
+        is_open = false;
+      }
+      if (is_open && (events[i].events & EPOLLIN))
+      {
+        is_open = receive(connection);
+      }
+      if (is_open && (events[i].events & EPOLLOUT))
+      {
+        is_open = flush(connection);
+      }
+
+      if (!is_open)
+      {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+        close(connection->fd);
+        connections.erase(connection->fd);
+        delete connection;
+        continue;
+      }
+
+      bool want_out = connection->out_pos < connection->out.length();
+      if (want_out != connection->want_out)
+      {
+        struct epoll_event event;
+        event.events = EPOLLIN | (want_out ? (uint32_t)EPOLLOUT : 0u);
+        event.data.ptr = connection;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->want_out = want_out;
+      }
+    }
+  }
+
+  for (std::map<int, Connection *>::iterator it = connections.begin(); it != connections.end(); ++it)
+  {
+    close(it->first);
+    delete it->second;
+  }
+}
+
+// false once the connection is to be closed
+bool MockRtdb::receive(Connection *connection)
+{
+  char buffer[64 * 1024];
+  uint64_t received = 0;
+  for (;;)
+  {
+    ssize_t n = read(connection->fd, buffer, sizeof(buffer));
+    if (n > 0)
+    {
+      connection->in.append(buffer, (size_t)n);
+      received += (uint64_t)n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      break;
+    }
+    return false; // closed by the client, or an error
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.bytes_in += received;
+  }
+
+  // every complete request in the buffer, pipelined ones included
+  for (;;)
+  {
+    std::string::size_type head_end = connection->in.find("\r\n\r\n");
+    if (head_end == std::string::npos)
+    {
+      if (connection->in.length() > mock_head_max)
+      {
+        respond(connection, 431, "", false);
+        return flush(connection);
+      }
+      break;
+    }
+    std::string head = connection->in.substr(0, head_end);
+    size_t body_len = (size_t)strtoull(mockHeader(mockLower(head), "content-length").c_str(), NULL, 10);
+    if (connection->in.length() < head_end + 4 + body_len)
+    {
+      break;
+    }
+    std::string body = connection->in.substr(head_end + 4, body_len);
+    connection->in.erase(0, head_end + 4 + body_len);
+    if (!handle(connection, head, body))
+    {
+      break;
+    }
+  }
+  return flush(connection);
+}
+
+// false if no more requests are read from the connection
+bool MockRtdb::handle(Connection *connection, const std::string &head, const std::string &body)
+{
+  std::string head_lower = mockLower(head);
+  bool keep_alive = head_lower.find(" http/1.0") == std::string::npos &&
+                    mockHeader(head_lower, "connection") != "close";
+
+  char method[16], target[1024];
+  if (sscanf(head.c_str(), "%15s %1023s", method, target) != 2)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      counters.bad_requests++;
+    }
+    respond(connection, 400, "", false);
+    return false;
+  }
+
+  std::string path = target;
+  std::string query;
+  std::string::size_type question = path.find('?');
+  if (question != std::string::npos)
+  {
+    query = path.substr(question + 1);
+    path.erase(question);
+  }
+  const std::string suffix = ".json";
+  if (path.length() >= suffix.length() && path.compare(path.length() - suffix.length(), suffix.length(), suffix) == 0)
+  {
+    path.erase(path.length() - suffix.length());
+  }
+  while (path.length() > 1 && path[path.length() - 1] == '/')
+  {
+    path.erase(path.length() - 1);
+  }
+  bool silent = query.find("print=silent") != std::string::npos;
+
+  std::string answer;
+  int status = 200;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.requests++;
+    if (strcmp(method, "GET") == 0)
+    {
+      std::map<std::string, std::string>::const_iterator it = store.find(path);
+      answer = (it == store.end()) ? "null" : it->second;
+    }
+    else if (strcmp(method, "PUT") == 0)
+    {
+      store[path] = body;
+      answer = body;
+    }
+    else if (strcmp(method, "PATCH") == 0)
+    {
+      patch(path, body);
+      answer = body;
+    }
+    else
+    {
+      counters.bad_requests++;
+      status = 405;
+    }
+  }
+
+  if (silent && status == 200)
+  {
+    status = 204;
+    answer.clear();
+  }
+  respond(connection, status, answer, keep_alive);
+  return keep_alive;
+}
+
+// stores each top level member of a JSON object, called with the mutex held
+void MockRtdb::patch(const std::string &path, const std::string &body)
+{
+  size_t pos = body.find('{');
+  if (pos == std::string::npos)
+  {
+    return;
+  }
+  pos++;
+  for (;;)
+  {
+    size_t key_start = body.find('"', pos);
+    if (key_start == std::string::npos)
+    {
+      return;
+    }
+    size_t key_end = body.find('"', key_start + 1);
+    size_t colon = (key_end == std::string::npos) ? key_end : body.find(':', key_end);
+    if (colon == std::string::npos)
+    {
+      return;
+    }
+
+    // the value runs to the next ',' or '}' outside strings and brackets
+    size_t value_start = colon + 1;
+    size_t at = value_start;
+    int depth = 0;
+    bool in_string = false;
+    for (; at < body.length(); at++)
+    {
+      char c = body[at];
+      if (in_string)
+      {
+        if (c == '\\')
+        {
+          at++;
+        }
+        else if (c == '"')
+        {
+          in_string = false;
+        }
+      }
+      else if (c == '"')
+      {
+        in_string = true;
+      }
+      else if (c == '{' || c == '[')
+      {
+        depth++;
+      }
+      else if ((c == '}' || c == ']') && depth > 0)
+      {
+        depth--;
+      }
+      else if ((c == ',' || c == '}') && depth == 0)
+      {
+        break;
+      }
+    }
+
+    std::string value = body.substr(value_start, at - value_start);
+    size_t first = value.find_first_not_of(" \t\r\n");
+    size_t last = value.find_last_not_of(" \t\r\n");
+    value = (first == std::string::npos) ? "null" : value.substr(first, last - first + 1);
+    store[path + "/" + body.substr(key_start + 1, key_end - key_start - 1)] = value;
+
+    if (at >= body.length() || body[at] == '}')
+    {
+      return;
+    }
+    pos = at + 1;
+  }
+}
+
+void MockRtdb::respond(Connection *connection, int status, const std::string &body, bool keep_alive)
+{
+  const char *reason = (status == 200) ? "OK" : (status == 204) ? "No Content"
+                     : (status == 405) ? "Method Not Allowed" : (status == 431) ? "Request Header Fields Too Large"
+                     : "Bad Request";
+  char head[256];
+  int len = snprintf(head, sizeof(head),
+                     "HTTP/1.1 %d %s\r\nContent-Type: application/json; charset=utf-8\r\n"
+                     "Content-Length: %zu\r\nConnection: %s\r\n\r\n",
+                     status, reason, body.length(), keep_alive ? "keep-alive" : "close");
+  connection->out.append(head, (size_t)len);
+  connection->out.append(body);
+  if (!keep_alive)
+  {
+    connection->close_after = true;
+  }
+}
+
+// false once everything is sent on a connection that is to be closed
+bool MockRtdb::flush(Connection *connection)
+{
+  uint64_t sent = 0;
+  bool is_open = true;
+  while (connection->out_pos < connection->out.length())
+  {
+    ssize_t n = send(connection->fd, connection->out.data() + connection->out_pos,
+                     connection->out.length() - connection->out_pos, MSG_NOSIGNAL);
+    if (n > 0)
+    {
+      connection->out_pos += (size_t)n;
+      sent += (uint64_t)n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    is_open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    break;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.bytes_out += sent;
+  }
+
+  if (connection->out_pos == connection->out.length())
+  {
+    connection->out.clear();
+    connection->out_pos = 0;
+    if (connection->close_after)
+    {
+      return false;
+    }
+  }
+  return is_open;
+}
+/*****************************************************************************/
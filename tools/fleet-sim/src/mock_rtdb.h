@@ -0,0 +1,67 @@
+#ifndef MOCK_RTDB_H
+#define MOCK_RTDB_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**************************Mock Realtime Database******************************/
+// Local stand-in for the Firebase Realtime Database REST API, enough for the
+// camera firmware's requests:
+//   GET    /<path>.json   stored value, or null
+//   PUT    /<path>.json   stores the body, answers with it
+//   PATCH  /<path>.json   stores each member of the body object under <path>
+// HTTP/1.1 with keep-alive, plain TCP, one epoll thread. Values are kept per
+// path as raw JSON; a PUT does not replace the children of its path.
+// "?print=silent" answers 204 without a body, like the real service.
+
+typedef struct _SMockRtdbStats
+{
+  uint64_t requests;
+  uint64_t bytes_in;  // request line, headers and body
+  uint64_t bytes_out;
+  uint64_t connections;
+  uint64_t bad_requests;
+} MockRtdbStats;
+
+class MockRtdb
+{
+public:
+  MockRtdb(void);
+  ~MockRtdb(void);
+
+  bool start(uint16_t port); // 0 picks a free port
+  void stop(void);
+  uint16_t port(void) const { return listen_port; }
+
+  void put(const std::string &path, const std::string &json); // for seeding
+  MockRtdbStats stats(void);
+
+private:
+  struct Connection;
+
+  int listen_fd;
+  int epoll_fd;
+  int wake_fd;
+  uint16_t listen_port;
+  std::thread thread;
+  std::atomic<bool> running;
+
+  std::mutex mutex; // store and stats, the test driver seeds and reads them
+  std::map<std::string, std::string> store;
+  MockRtdbStats counters;
+
+  void run(void);
+  bool receive(Connection *connection);
+  bool handle(Connection *connection, const std::string &head, const std::string &body);
+  void respond(Connection *connection, int status, const std::string &body, bool keep_alive);
+  bool flush(Connection *connection);
+  void patch(const std::string &path, const std::string &body);
+};
+/*****************************************************************************/
+
+#endif
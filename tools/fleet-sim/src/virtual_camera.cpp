@@ -0,0 +1,298 @@
+#include "virtual_camera.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+/**************************global variables***********************************/
+static const int camera_timeout_s = 10; // the Firebase client's default is 10 s too
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+VirtualCamera::VirtualCamera(const FleetConfig *config, unsigned id, const std::string *image_pool)
+    : config(config), image_pool(image_pool), fd(-1), rng(id * 2654435761u + 1),
+      born(FleetClock::now()), last_check(born), last_signal(-1), event_count(0)
+{
+  char location[16];
+  snprintf(location, sizeof(location), "cam%03u", id);
+  device_location = location;
+  std::string database_path = "/" + device_location;
+  sensor_control_path = database_path + "/sensor_control";
+  signal_path = database_path + "/sgndata";
+  photo_path = database_path + "/imgdata";
+  event_path = database_path + "/evtdata";
+
+  memset(stats.requests, 0, sizeof(stats.requests));
+  memset(stats.bytes_up, 0, sizeof(stats.bytes_up));
+  memset(stats.bytes_down, 0, sizeof(stats.bytes_down));
+  stats.errors = 0;
+  stats.motions = 0;
+}
+
+VirtualCamera::~VirtualCamera(void)
+{
+  disconnect();
+}
+
+bool VirtualCamera::connectServer(void)
+{
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  struct timeval timeout = {camera_timeout_s, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(config->port);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+  {
+    disconnect();
+    return false;
+  }
+  return true;
+}
+
+void VirtualCamera::disconnect(void)
+{
+  if (fd >= 0)
+  {
+    close(fd);
+    fd = -1;
+  }
+}
+
+// gathers the head and the body slices without copying them together
+bool VirtualCamera::sendAll(const char *const parts[], const size_t lens[], int count)
+{
+  struct iovec iov[8];
+  for (int i = 0; i < count; i++)
+  {
+    iov[i].iov_base = (void *)parts[i];
+    iov[i].iov_len = lens[i];
+  }
+
+  struct iovec *next = iov;
+  while (count > 0)
+  {
+    ssize_t n = writev(fd, next, count);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    while (count > 0 && (size_t)n >= next->iov_len)
+    {
+      n -= (ssize_t)next->iov_len;
+      next++;
+      count--;
+    }
+    if (count > 0)
+    {
+      next->iov_base = (char *)next->iov_base + n;
+      next->iov_len -= (size_t)n;
+    }
+  }
+  return true;
+}
+
+// reads one response, *answer is its body if the status was 2xx
+bool VirtualCamera::receiveResponse(std::string *answer)
+{
+  char buffer[16 * 1024];
+  response.clear();
+  size_t head_end = std::string::npos;
+  size_t body_len = 0;
+
+  for (;;)
+  {
+    if (head_end == std::string::npos)
+    {
+      head_end = response.find("\r\n\r\n");
+      if (head_end != std::string::npos)
+      {
+        const char *length = strcasestr(response.c_str(), "\r\ncontent-length:");
+        body_len = (length != NULL && length < response.c_str() + head_end)
+                       ? (size_t)strtoull(length + 17, NULL, 10) : 0;
+      }
+    }
+    if (head_end != std::string::npos && response.length() >= head_end + 4 + body_len)
+    {
+      break;
+    }
+
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    response.append(buffer, (size_t)n);
+  }
+
+  int status = 0;
+  if (sscanf(response.c_str(), "HTTP/1.%*d %d", &status) != 1 || status < 200 || status > 299)
+  {
+    return false;
+  }
+  if (answer != NULL)
+  {
+    answer->assign(response, head_end + 4, body_len);
+  }
+  return true;
+}
+
+bool VirtualCamera::request(RequestKind kind, const char *method, const std::string &path,
+                            const char *const body[], const size_t body_lens[], int body_count,
+                            std::string *answer)
+{
+  size_t content_len = 0;
+  for (int i = 0; i < body_count; i++)
+  {
+    content_len += body_lens[i];
+  }
+
+  char head[512];
+  int head_len = snprintf(head, sizeof(head),
+                          "%s %s.json%s HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                          "Content-Type: application/json\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+                          method, path.c_str(), config->silent && strcmp(method, "GET") != 0 ? "?print=silent" : "",
+                          content_len, config->keep_alive ? "keep-alive" : "close");
+
+  const char *parts[8] = {head};
+  size_t lens[8] = {(size_t)head_len};
+  for (int i = 0; i < body_count; i++)
+  {
+    parts[i + 1] = body[i];
+    lens[i + 1] = body_lens[i];
+  }
+
+  FleetClock::time_point start = FleetClock::now();
+  bool is_ok = (fd >= 0 || connectServer()) && sendAll(parts, lens, body_count + 1) &&
+               receiveResponse(answer);
+  FleetClock::time_point end = FleetClock::now();
+
+  stats.requests[kind]++;
+  stats.bytes_up[kind] += (uint64_t)head_len + content_len;
+  stats.bytes_down[kind] += response.length();
+  if (!is_ok)
+  {
+    stats.errors++;
+    disconnect();
+    return false;
+  }
+  stats.latency_us[kind].push_back(
+      (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+  if (!config->keep_alive)
+  {
+    disconnect();
+  }
+  return true;
+}
+
+FleetClock::time_point VirtualCamera::runPass(FleetClock::time_point due)
+{
+  FleetClock::time_point now = FleetClock::now();
+  stats.lag_us.push_back(
+      (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(now - std::min(now, due)).count());
+
+  // Firebase.getString(sensor_control); on failure or with the sensor off
+  // loop() starts over at once
+  std::string sensor_control;
+  if (!request(REQ_GET_SENSOR, "GET", sensor_control_path, NULL, NULL, 0, &sensor_control) ||
+      sensor_control != "\"true\"")
+  {
+    return FleetClock::now();
+  }
+
+  // digitalRead(motion_pin)
+  now = FleetClock::now();
+  double minutes = std::chrono::duration<double>(now - last_check).count() / 60.0;
+  last_check = now;
+  bool is_motion_detected =
+      std::uniform_real_distribution<double>(0.0, 1.0)(rng) < 1.0 - exp(-config->motion_per_min * minutes);
+
+  char eid[9];
+  uint32_t motion_ms = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(now - born).count();
+  if (is_motion_detected)
+  {
+    snprintf(eid, sizeof(eid), "%08x", (unsigned)(rng() ^ event_count++));
+    stats.motions++;
+  }
+
+  // sendMotionSignalToFirebase()
+  if (!config->signal_on_change || last_signal != (int)is_motion_detected)
+  {
+    if (is_motion_detected)
+    {
+      char json[64];
+      const char *body[] = {json};
+      size_t body_lens[] = {(size_t)snprintf(json, sizeof(json), "{\"sgndata\":1,\"evtid\":\"%s\"}", eid)};
+      request(REQ_PATCH_SIGNAL, "PATCH", "/" + device_location, body, body_lens, 1, NULL);
+    }
+    else
+    {
+      const char *body[] = {"0"};
+      size_t body_lens[] = {1};
+      request(REQ_PUT_SIGNAL, "PUT", signal_path, body, body_lens, 1, NULL);
+    }
+    last_signal = is_motion_detected;
+  }
+
+  FleetClock::time_point next;
+  if (is_motion_detected)
+  {
+    // getPhotoThenSendToFirebase(): photo2Base64() output, \" wrapped
+    uint32_t jitter = config->image_jitter;
+    uint32_t jpeg = config->image_bytes - jitter +
+                    std::uniform_int_distribution<uint32_t>(0, 2 * jitter)(rng);
+    size_t digits = std::min(image_pool->length(), (size_t)(jpeg + 2) / 3 * 4 + 4);
+    const char *body[] = {"\"\\\"", image_pool->data(), "\\\"\""};
+    size_t body_lens[] = {3, digits, 3};
+    bool is_uploaded = request(REQ_PUT_IMAGE, "PUT", photo_path, body, body_lens, 3, NULL);
+
+    if (is_uploaded && config->trace_upload)
+    {
+      // sendTraceEventToFirebase()
+      uint32_t upload_ms = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                               FleetClock::now() - born).count();
+      char json[160];
+      const char *event_body[] = {json};
+      size_t event_lens[] = {(size_t)snprintf(
+          json, sizeof(json),
+          "{\"motion\":%u,\"capture\":%u,\"encode\":%u,\"upload_ack\":%u,\"srv\":{\".sv\":\"timestamp\"}}",
+          motion_ms, motion_ms, motion_ms, upload_ms)};
+      request(REQ_PUT_EVENT, "PUT", event_path + "/" + eid, event_body, event_lens, 1, NULL);
+    }
+    next = FleetClock::now() + std::chrono::milliseconds(config->cooldown_ms);
+  }
+  else
+  {
+    next = FleetClock::now();
+  }
+  return next + std::chrono::milliseconds(config->pass_delay_ms);
+}
+/*****************************************************************************/
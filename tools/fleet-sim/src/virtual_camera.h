@@ -0,0 +1,99 @@
+#ifndef VIRTUAL_CAMERA_H
+#define VIRTUAL_CAMERA_H
+
+#include <stdint.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+/**************************Virtual camera**************************************/
+// One ESP32-CAM, running the same database traffic as loop() in
+// image-transfer-module/src/main.cpp, pass by pass:
+//   GET  sensor_control                       every pass
+//   PUT  sgndata 0, or PATCH sgndata 1+evtid  if the sensor is on
+//   PUT  imgdata                              on motion, then delay(10000)
+//   PUT  evtdata/<eid>                        after imgdata, TRACE_UPLOAD_ENABLED
+//   delay(100)                                if the sensor is on
+// The PIR fires as a Poisson process. Requests go to the mock database over
+// HTTP/1.1, blocking, one connection per device like the Firebase client.
+
+typedef std::chrono::steady_clock FleetClock;
+
+typedef enum _ERequestKind
+{
+  REQ_GET_SENSOR,
+  REQ_PUT_SIGNAL,
+  REQ_PATCH_SIGNAL,
+  REQ_PUT_IMAGE,
+  REQ_PUT_EVENT,
+  REQ_KINDS
+} RequestKind;
+
+typedef struct _SFleetConfig
+{
+  uint16_t port;
+  double motion_per_min;  // PIR events per minute and device
+  uint32_t image_bytes;   // JPEG size before Base64
+  uint32_t image_jitter;  // +- uniform around image_bytes
+  uint32_t pass_delay_ms; // delay(100) at the end of a pass
+  uint32_t cooldown_ms;   // delay(10000) after a photo
+  bool signal_on_change;  // only write sgndata when it changes
+  bool keep_alive;
+  bool silent;            // ?print=silent, no echo of written data
+  bool trace_upload;      // firmware built with TRACE_UPLOAD_ENABLED
+} FleetConfig;
+
+typedef struct _SDeviceStats
+{
+  uint64_t requests[REQ_KINDS];
+  uint64_t bytes_up[REQ_KINDS];   // request head and body
+  uint64_t bytes_down[REQ_KINDS]; // response head and body
+  uint64_t errors;
+  uint32_t motions;
+  std::vector<uint32_t> latency_us[REQ_KINDS];
+  std::vector<uint32_t> lag_us;   // pass start behind schedule
+} DeviceStats;
+
+class VirtualCamera
+{
+public:
+  // image_pool: Base64 digits, at least as long as the largest photo
+  VirtualCamera(const FleetConfig *config, unsigned id, const std::string *image_pool);
+  ~VirtualCamera(void);
+
+  // one pass of loop(), returns when the next one is due
+  FleetClock::time_point runPass(FleetClock::time_point due);
+
+  const std::string &location(void) const { return device_location; }
+  DeviceStats stats;
+
+private:
+  const FleetConfig *config;
+  const std::string *image_pool;
+  std::string device_location;
+  std::string sensor_control_path;
+  std::string signal_path;
+  std::string photo_path;
+  std::string event_path;
+
+  int fd;
+  std::string response; // receive buffer, reused
+  std::mt19937 rng;
+  FleetClock::time_point born;
+  FleetClock::time_point last_check; // last PIR read
+  int last_signal;                   // -1 before the first write
+  uint32_t event_count;
+
+  bool connectServer(void);
+  void disconnect(void);
+  bool sendAll(const char *const parts[], const size_t lens[], int count);
+  bool receiveResponse(std::string *answer);
+  bool request(RequestKind kind, const char *method, const std::string &path,
+               const char *const body[], const size_t body_lens[], int body_count,
+               std::string *answer);
+};
+/*****************************************************************************/
+
+#endif
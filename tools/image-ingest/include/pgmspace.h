@@ -0,0 +1,11 @@
+#ifndef PGMSPACE_H
+#define PGMSPACE_H
+
+/**************************pgmspace (host)************************************/
+// Lets image-transfer-module/src/Base64.cpp build on the host, where there
+// is no separate program memory.
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,129 @@
+#include "json_scanner.h"
+
+#include <string.h>
+
+/***************user-defined functions****************************************/
+JsonScanner::JsonScanner(const char *doc, size_t len, JsonKeyFilter filter)
+    : doc(doc), len(len), pos(0), filter(filter), expect_key(false), err(NULL)
+{
+}
+
+// index of the closing quote of a string whose body starts at from; a quote
+// preceded by an odd number of backslashes is escaped
+bool JsonScanner::stringEnd(size_t from, size_t *end) const
+{
+  size_t at = from;
+  for (;;)
+  {
+    const char *quote = (const char *)memchr(doc + at, '"', len - at);
+    if (quote == NULL)
+    {
+      return false;
+    }
+    at = quote - doc;
+
+    size_t backslashes = 0;
+    while (at - backslashes > from && doc[at - backslashes - 1] == '\\')
+    {
+      backslashes++;
+    }
+    if (backslashes % 2 == 0)
+    {
+      *end = at;
+      return true;
+    }
+    at++;
+  }
+}
+
+// numbers, true, false, null
+void JsonScanner::skipScalar(void)
+{
+  while (pos < len)
+  {
+    char c = doc[pos];
+    if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\r' || c == '\n')
+    {
+      return;
+    }
+    pos++;
+  }
+}
+
+bool JsonScanner::next(JsonMatch *match)
+{
+  while (err == NULL && pos < len)
+  {
+    char c = doc[pos];
+    switch (c)
+    {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+    case ':':
+      pos++;
+      break;
+    case ',':
+      pos++;
+      expect_key = !frames.empty() && frames.back().is_object;
+      break;
+    case '{':
+    case '[':
+    {
+      Frame frame = {c == '{', {NULL, 0}};
+      frames.push_back(frame);
+      expect_key = frame.is_object;
+      pos++;
+      break;
+    }
+    case '}':
+    case ']':
+      if (frames.empty() || frames.back().is_object != (c == '}'))
+      {
+        err = "unbalanced brackets";
+        break;
+      }
+      frames.pop_back();
+      expect_key = false;
+      pos++;
+      break;
+    case '"':
+    {
+      size_t end;
+      if (!stringEnd(pos + 1, &end))
+      {
+        err = "unterminated string";
+        break;
+      }
+      JsonSpan str = {doc + pos + 1, end - pos - 1};
+      pos = end + 1;
+
+      if (expect_key)
+      {
+        frames.back().key = str;
+        expect_key = false;
+      }
+      else if (!frames.empty() && frames.back().is_object && filter(frames.back().key))
+      {
+        JsonSpan none = {NULL, 0};
+        match->parent_key = (frames.size() >= 2) ? frames[frames.size() - 2].key : none;
+        match->key = frames.back().key;
+        match->value = str;
+        return true;
+      }
+      break;
+    }
+    default:
+      skipScalar();
+      break;
+    }
+  }
+
+  if (err == NULL && !frames.empty())
+  {
+    err = "unexpected end of document";
+  }
+  return false;
+}
+/*****************************************************************************/
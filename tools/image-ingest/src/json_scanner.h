@@ -0,0 +1,62 @@
+#ifndef JSON_SCANNER_H
+#define JSON_SCANNER_H
+
+#include <stddef.h>
+
+#include <vector>
+
+/**************************JSON scanner****************************************/
+// Walks a JSON document in place, e.g. a read-only mmap, and stops at every
+// string value whose key passes a filter. Nothing is copied or allocated per
+// value: spans point into the document and string values are the raw bytes
+// between the quotes, escapes included. The only state is one frame per
+// open object or array, holding the current key.
+// It is a scanner, not a validator: it needs balanced brackets and properly
+// terminated strings and skips everything else as it comes.
+
+typedef struct _SJsonSpan
+{
+  const char *ptr;
+  size_t len;
+} JsonSpan;
+
+typedef struct _SJsonMatch
+{
+  JsonSpan parent_key; // key of the object holding the value, empty at the top
+  JsonSpan key;
+  JsonSpan value;      // raw, between the quotes
+} JsonMatch;
+
+typedef bool (*JsonKeyFilter)(const JsonSpan &key);
+
+class JsonScanner
+{
+public:
+  JsonScanner(const char *doc, size_t len, JsonKeyFilter filter);
+
+  // false at the end of the document or on an error, see error()
+  bool next(JsonMatch *match);
+  size_t position(void) const { return pos; } // everything before is scanned
+  const char *error(void) const { return err; } // NULL unless the scan failed
+
+private:
+  typedef struct _SFrame
+  {
+    bool is_object;
+    JsonSpan key;
+  } Frame;
+
+  const char *doc;
+  size_t len;
+  size_t pos;
+  JsonKeyFilter filter;
+  std::vector<Frame> frames;
+  bool expect_key;
+  const char *err;
+
+  bool stringEnd(size_t from, size_t *end) const;
+  void skipScalar(void);
+};
+/*****************************************************************************/
+
+#endif
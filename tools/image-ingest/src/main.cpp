@@ -0,0 +1,657 @@
+/**************************Image ingest****************************************/
+// Pulls every imgdata / imgdata_N photo out of a Realtime Database JSON
+// export, decodes it with the firmware's own Base64.cpp and writes
+//   <out>/<location>/<key>.jpg   and   <out>/index.csv
+//
+//   program [-j threads] [-o dir] [-n] export.json
+//
+// The export is mapped read-only and scanned in place by one thread, which
+// hands (pointer, length) spans into the mapping to the decode workers over a
+// bounded queue. Pages behind the oldest span still in use are dropped again,
+// so exports far larger than RAM go through with a flat footprint.
+/*****************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Base64.h"
+#include "json_scanner.h"
+
+/**************************typedef *******************************************/
+typedef struct _SIngestOptions
+{
+  unsigned threads;
+  std::string out_dir;
+  bool dry_run; // decode only, write nothing
+  std::string export_path;
+} IngestOptions;
+
+typedef struct _SIngestJob
+{
+  std::string location; // the database key, unescaped
+  std::string dir;      // location as a file name
+  std::string key;
+  const char *base64; // into the mapping, JSON escapes still in place
+  size_t len;
+  size_t offset;      // of base64 in the export
+} IngestJob;
+
+typedef enum _EIngestStatus
+{
+  INGEST_OK,
+  INGEST_NO_EOI,   // no end of image marker, kept whole
+  INGEST_NOT_JPEG, // no start of image marker, written as .bin
+  INGEST_WRITE_FAILED
+} IngestStatus;
+
+typedef struct _SIngestImage
+{
+  std::string location;
+  std::string key;
+  size_t bytes;
+  std::string file;
+  IngestStatus status;
+} IngestImage;
+
+typedef struct _SIngestWorker
+{
+  std::vector<IngestImage> images;
+  uint64_t base64_bytes;
+  uint64_t jpeg_bytes;
+  double busy_s;
+} IngestWorker;
+/*****************************************************************************/
+
+/**************************global variables***********************************/
+static const char *const ingest_status_name[] = {"ok", "no_eoi", "not_jpeg", "write_failed"};
+static const size_t ingest_release_step = 64UL << 20; // drop scanned pages every 64 MB
+/*****************************************************************************/
+
+/**************************job queue******************************************/
+// Bounded, so the scanner cannot run ahead of the workers, and it knows the
+// lowest offset still queued or being decoded.
+class IngestQueue
+{
+public:
+  explicit IngestQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+  void push(const IngestJob &job)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this] { return jobs.size() < capacity; });
+    jobs.push_back(job);
+    in_use.insert(job.offset);
+    not_empty.notify_one();
+  }
+
+  bool pop(IngestJob *job) // false once closed and drained
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_empty.wait(lock, [this] { return !jobs.empty() || closed; });
+    if (jobs.empty())
+    {
+      return false;
+    }
+    *job = jobs.front();
+    jobs.pop_front();
+    not_full.notify_one();
+    return true;
+  }
+
+  void done(size_t offset)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    in_use.erase(in_use.find(offset));
+  }
+
+  void close(void)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    not_empty.notify_all();
+  }
+
+  size_t oldestInUse(size_t otherwise)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return in_use.empty() ? otherwise : *in_use.begin();
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+  std::deque<IngestJob> jobs;
+  std::multiset<size_t> in_use;
+  size_t capacity;
+  bool closed;
+};
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static void ingestUsage(void)
+{
+  std::cerr << "usage: program [-j threads] [-o dir] [-n] export.json\n"
+               "  -j  decode threads, default: all cores\n"
+               "  -o  output directory, default: images\n"
+               "  -n  decode only, write no files\n";
+}
+
+static bool ingestParseArgs(int argc, char **argv, IngestOptions *options)
+{
+  options->threads = std::max(1u, std::thread::hardware_concurrency());
+  options->out_dir = "images";
+  options->dry_run = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc)
+    {
+      options->threads = (unsigned)strtoul(argv[++i], NULL, 10);
+      if (options->threads == 0)
+      {
+        return false;
+      }
+    }
+    else if (arg == "-o" && i + 1 < argc)
+    {
+      options->out_dir = argv[++i];
+    }
+    else if (arg == "-n")
+    {
+      options->dry_run = true;
+    }
+    else if (options->export_path.empty() && arg[0] != '-')
+    {
+      options->export_path = arg;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return !options->export_path.empty();
+}
+
+// imgdata from getPhotoThenSendToFirebase(), imgdata_N from ...WithIndex()
+static bool ingestIsPhotoKey(const JsonSpan &key)
+{
+  static const char name[] = "imgdata";
+  const size_t name_len = sizeof(name) - 1;
+  if (key.len < name_len || memcmp(key.ptr, name, name_len) != 0)
+  {
+    return false;
+  }
+  if (key.len == name_len)
+  {
+    return true;
+  }
+  if (key.len == name_len + 1 || key.ptr[name_len] != '_')
+  {
+    return false;
+  }
+  for (size_t i = name_len + 1; i < key.len; i++)
+  {
+    if (key.ptr[i] < '0' || key.ptr[i] > '9')
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void ingestAppendUtf8(std::string *str, uint32_t code)
+{
+  if (code < 0x80)
+  {
+    *str += (char)code;
+  }
+  else if (code < 0x800)
+  {
+    *str += (char)(0xC0 | (code >> 6));
+    *str += (char)(0x80 | (code & 0x3F));
+  }
+  else if (code < 0x10000)
+  {
+    *str += (char)(0xE0 | (code >> 12));
+    *str += (char)(0x80 | ((code >> 6) & 0x3F));
+    *str += (char)(0x80 | (code & 0x3F));
+  }
+  else
+  {
+    *str += (char)(0xF0 | (code >> 18));
+    *str += (char)(0x80 | ((code >> 12) & 0x3F));
+    *str += (char)(0x80 | ((code >> 6) & 0x3F));
+    *str += (char)(0x80 | (code & 0x3F));
+  }
+}
+
+static bool ingestHex4(const char *ptr, size_t len, size_t at, uint32_t *code)
+{
+  if (at + 4 > len)
+  {
+    return false;
+  }
+  *code = 0;
+  for (size_t i = at; i < at + 4; i++)
+  {
+    char c = ptr[i];
+    uint32_t digit = (c >= '0' && c <= '9')   ? (uint32_t)(c - '0')
+                     : (c >= 'a' && c <= 'f') ? (uint32_t)(c - 'a' + 10)
+                     : (c >= 'A' && c <= 'F') ? (uint32_t)(c - 'A' + 10)
+                                              : 16;
+    if (digit == 16)
+    {
+      return false;
+    }
+    *code = *code * 16 + digit;
+  }
+  return true;
+}
+
+// a key as the database has it, the JSON escapes of the export undone
+static std::string ingestKeyText(const JsonSpan &span)
+{
+  std::string text;
+  for (size_t i = 0; i < span.len; i++)
+  {
+    char c = span.ptr[i];
+    if (c != '\\' || i + 1 == span.len)
+    {
+      text += c;
+      continue;
+    }
+    c = span.ptr[++i];
+    switch (c)
+    {
+    case 'b':
+      text += '\b';
+      break;
+    case 'f':
+      text += '\f';
+      break;
+    case 'n':
+      text += '\n';
+      break;
+    case 'r':
+      text += '\r';
+      break;
+    case 't':
+      text += '\t';
+      break;
+    case 'u':
+    {
+      uint32_t code, low;
+      if (!ingestHex4(span.ptr, span.len, i + 1, &code))
+      {
+        text += "\\u";
+        break;
+      }
+      i += 4;
+      // a surrogate pair is one character in two escapes
+      if (code >= 0xD800 && code < 0xDC00 && i + 2 < span.len && span.ptr[i + 1] == '\\' &&
+          span.ptr[i + 2] == 'u' && ingestHex4(span.ptr, span.len, i + 3, &low) && low >= 0xDC00 &&
+          low < 0xE000)
+      {
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        i += 6;
+      }
+      ingestAppendUtf8(&text, code);
+      break;
+    }
+    default: // \" \\ \/
+      text += c;
+      break;
+    }
+  }
+  return text;
+}
+
+// database keys cannot hold '/', but keep the output tree flat regardless
+static std::string ingestFileName(const std::string &key)
+{
+  if (key.empty())
+  {
+    return "_";
+  }
+  std::string name(key);
+  for (size_t i = 0; i < name.length(); i++)
+  {
+    if (name[i] == '/' || name[i] == '\\' || (unsigned char)name[i] < 0x20 || (i == 0 && name[i] == '.'))
+    {
+      name[i] = '_';
+    }
+  }
+  return name;
+}
+
+static bool ingestIsBase64(char c)
+{
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+         c == '+' || c == '/' || c == '=';
+}
+
+// photo2Base64() wraps the data in \" ... \", which the export escapes again
+static void ingestTrim(const char **ptr, size_t *len)
+{
+  while (*len > 0 && !ingestIsBase64(**ptr))
+  {
+    (*ptr)++;
+    (*len)--;
+  }
+  while (*len > 0 && !ingestIsBase64((*ptr)[*len - 1]))
+  {
+    (*len)--;
+  }
+}
+
+// slow path for values with JSON escapes left inside, e.g. "\/"
+static size_t ingestUnescape(const char *ptr, size_t len, std::vector<char> *out)
+{
+  out->resize(len);
+  size_t n = 0;
+  for (size_t i = 0; i < len; i++)
+  {
+    char c = ptr[i];
+    if (c == '\\' && i + 1 < len)
+    {
+      c = ptr[++i];
+      if (c == 'u')
+      {
+        i += 4; // no Base64 digit is ever written as \uXXXX
+      }
+      if (c != '/') // \n, \t, ... are not Base64 even though n, t are
+      {
+        continue;
+      }
+    }
+    if (ingestIsBase64(c))
+    {
+      (*out)[n++] = c;
+    }
+  }
+  return n;
+}
+
+// photo2Base64() encodes whole 3 byte groups from the frame buffer and then
+// the last group once more, so up to 5 stray bytes follow the EOI marker
+static IngestStatus ingestCheckJpeg(const unsigned char *data, size_t *len)
+{
+  if (*len < 4 || data[0] != 0xFF || data[1] != 0xD8)
+  {
+    return INGEST_NOT_JPEG;
+  }
+  size_t stop = (*len > 8) ? *len - 8 : 2;
+  for (size_t i = *len - 1; i > stop; i--)
+  {
+    if (data[i - 1] == 0xFF && data[i] == 0xD9)
+    {
+      *len = i + 1;
+      return INGEST_OK;
+    }
+  }
+  return INGEST_NO_EOI;
+}
+
+static bool ingestWriteFile(const std::string &path, const char *data, size_t len)
+{
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    return false;
+  }
+  while (len > 0)
+  {
+    ssize_t written = write(fd, data, len);
+    if (written < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (written <= 0)
+    {
+      close(fd);
+      return false;
+    }
+    data += written;
+    len -= (size_t)written;
+  }
+  return close(fd) == 0;
+}
+
+static void ingestWorker(IngestQueue *queue, const IngestOptions *options, IngestWorker *worker)
+{
+  std::vector<char> text;
+  std::vector<char> data;
+  IngestJob job;
+
+  while (queue->pop(&job))
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const char *base64 = job.base64;
+    size_t len = job.len;
+    ingestTrim(&base64, &len);
+    if (memchr(base64, '\\', len) != NULL)
+    {
+      len = ingestUnescape(base64, len, &text);
+      base64 = text.data();
+    }
+
+    // straight out of the mapping unless it had to be unescaped;
+    // base64_decode() takes char * but only reads the input
+    data.resize(len / 4 * 3 + 4);
+    size_t bytes = (size_t)base64_decode(data.data(), (char *)base64, (int)len);
+
+    IngestImage image;
+    image.location = job.location;
+    image.key = job.key;
+    image.status = ingestCheckJpeg((const unsigned char *)data.data(), &bytes);
+    image.bytes = bytes;
+
+    std::string dir = options->out_dir + "/" + job.dir;
+    image.file = job.dir + "/" + job.key + (image.status == INGEST_NOT_JPEG ? ".bin" : ".jpg");
+    if (!options->dry_run)
+    {
+      if ((mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) ||
+          !ingestWriteFile(options->out_dir + "/" + image.file, data.data(), bytes))
+      {
+        image.status = INGEST_WRITE_FAILED;
+      }
+    }
+
+    queue->done(job.offset);
+    worker->images.push_back(image);
+    worker->base64_bytes += job.len;
+    worker->jpeg_bytes += bytes;
+    worker->busy_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+static bool ingestImageLess(const IngestImage &a, const IngestImage &b)
+{
+  if (a.location != b.location)
+  {
+    return a.location < b.location;
+  }
+  if (a.key.length() != b.key.length()) // imgdata_2 before imgdata_10
+  {
+    return a.key.length() < b.key.length();
+  }
+  return a.key < b.key;
+}
+
+// RFC 4180 field: quoted, inner quotes doubled; database keys may hold , or "
+static std::string ingestCsvField(const std::string &str)
+{
+  std::string field = "\"";
+  for (size_t i = 0; i < str.length(); i++)
+  {
+    if (str[i] == '"')
+    {
+      field += '"';
+    }
+    field += str[i];
+  }
+  return field + "\"";
+}
+
+static bool ingestWriteIndex(const std::string &path, const std::vector<IngestImage> &images)
+{
+  FILE *file = fopen(path.c_str(), "w");
+  if (file == NULL)
+  {
+    return false;
+  }
+  fprintf(file, "location,index,bytes,status,file\n");
+  for (size_t i = 0; i < images.size(); i++)
+  {
+    const IngestImage &image = images[i];
+    std::string::size_type underscore = image.key.find('_');
+    std::string index = (underscore == std::string::npos) ? "" : image.key.substr(underscore + 1);
+    fprintf(file, "%s,%s,%zu,%s,%s\n", ingestCsvField(image.location).c_str(), index.c_str(), image.bytes,
+            ingest_status_name[image.status], ingestCsvField(image.file).c_str());
+  }
+  return fclose(file) == 0;
+}
+
+int main(int argc, char **argv)
+{
+  IngestOptions options;
+  if (!ingestParseArgs(argc, argv, &options))
+  {
+    ingestUsage();
+    return 2;
+  }
+
+  int fd = open(options.export_path.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0)
+  {
+    std::cerr << options.export_path << ": " << strerror(errno) << "\n";
+    return 2;
+  }
+  size_t size = (size_t)st.st_size;
+  if (size == 0)
+  {
+    std::cerr << options.export_path << ": empty\n";
+    return 2;
+  }
+  const char *doc = (const char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (doc == MAP_FAILED)
+  {
+    std::cerr << options.export_path << ": mmap: " << strerror(errno) << "\n";
+    return 2;
+  }
+  madvise((void *)doc, size, MADV_SEQUENTIAL);
+
+  if (!options.dry_run && mkdir(options.out_dir.c_str(), 0755) != 0 && errno != EEXIST)
+  {
+    std::cerr << options.out_dir << ": " << strerror(errno) << "\n";
+    return 2;
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  IngestQueue queue(options.threads * 4);
+  std::vector<IngestWorker> workers(options.threads, IngestWorker());
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < options.threads; i++)
+  {
+    threads.push_back(std::thread(ingestWorker, &queue, &options, &workers[i]));
+  }
+
+  const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t released = 0;
+  JsonScanner scanner(doc, size, ingestIsPhotoKey);
+  JsonMatch match;
+  while (scanner.next(&match))
+  {
+    std::string location = ingestKeyText(match.parent_key);
+    IngestJob job = {location, ingestFileName(location), std::string(match.key.ptr, match.key.len),
+                     match.value.ptr, match.value.len, (size_t)(match.value.ptr - doc)};
+    queue.push(job);
+
+    if (scanner.position() - released >= ingest_release_step)
+    {
+      size_t low = queue.oldestInUse(scanner.position()) / page * page;
+      if (low > released)
+      {
+        madvise((void *)(doc + released), low - released, MADV_DONTNEED);
+        released = low;
+      }
+    }
+  }
+  double scan_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  queue.close();
+  for (size_t i = 0; i < threads.size(); i++)
+  {
+    threads[i].join();
+  }
+  double total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  munmap((void *)doc, size);
+
+  /* report */
+  std::vector<IngestImage> images;
+  uint64_t base64_bytes = 0, jpeg_bytes = 0;
+  double busy_s = 0;
+  for (size_t i = 0; i < workers.size(); i++)
+  {
+    images.insert(images.end(), workers[i].images.begin(), workers[i].images.end());
+    base64_bytes += workers[i].base64_bytes;
+    jpeg_bytes += workers[i].jpeg_bytes;
+    busy_s += workers[i].busy_s;
+  }
+  std::sort(images.begin(), images.end(), ingestImageLess);
+
+  unsigned status_count[sizeof(ingest_status_name) / sizeof(ingest_status_name[0])] = {0};
+  for (size_t i = 0; i < images.size(); i++)
+  {
+    status_count[images[i].status]++;
+  }
+
+  if (!options.dry_run && !ingestWriteIndex(options.out_dir + "/index.csv", images))
+  {
+    std::cerr << options.out_dir << "/index.csv: " << strerror(errno) << "\n";
+    return 1;
+  }
+
+  const double mb = 1024.0 * 1024.0;
+  printf("%s: %.1f MB, scan finished after %.2f s (%.0f MB/s)\n", options.export_path.c_str(), size / mb,
+         scan_s, size / mb / scan_s);
+  printf("images   %zu: %u ok, %u without EOI, %u not JPEG, %u not written\n", images.size(),
+         status_count[INGEST_OK], status_count[INGEST_NO_EOI], status_count[INGEST_NOT_JPEG],
+         status_count[INGEST_WRITE_FAILED]);
+  printf("decoded  %.1f MB Base64 to %.1f MB JPEG on %u threads, %.0f%% busy\n", base64_bytes / mb,
+         jpeg_bytes / mb, options.threads, 100.0 * busy_s / (total_s * options.threads));
+  printf("total    %.2f s, %.0f MB/s in, %.0f MB/s out, %.0f images/s\n", total_s,
+         size / mb / total_s, jpeg_bytes / mb / total_s, images.size() / total_s);
+
+  if (scanner.error() != NULL)
+  {
+    std::cerr << options.export_path << ": " << scanner.error() << " near byte "
+              << scanner.position() << "\n";
+    return 1;
+  }
+  return status_count[INGEST_WRITE_FAILED] ? 1 : 0;
+}
+/*****************************************************************************/
@@ -0,0 +1,697 @@
+/**************************Trace analyzer**************************************/
+// Joins the "T <eid> <stage> <ms>" records LOG_TRACE() writes on both
+// firmwares, and the evtdata records the camera keeps in the database, into
+// one timeline per motion event and prints per-hop latency distributions.
+//
+//   program [--db export.json] [--skew DEVICE=MS]... [--events] [DEVICE=]file.log...
+//
+// Hops within one device use that device's own millis(). Hops between two
+// devices need a common clock: either each log line starts with the host time
+// of `pio device monitor -f time` ("hh:mm:ss.mmm > "), or --skew adds a fixed
+// offset to a device's millis(). Database records belong to device "camera".
+/*****************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**************************typedef *******************************************/
+typedef enum _ETraceStage // in the order an event passes them
+{
+  STAGE_MOTION,
+  STAGE_CAPTURE,
+  STAGE_ENCODE,
+  STAGE_UPLOAD_ACK,
+  STAGE_BT_RX,
+  STAGE_LCD_DRAWN,
+  STAGES
+} TraceStage;
+
+typedef struct _SStamp
+{
+  bool is_set;
+  std::string device;
+  int64_t local_ms;  // the device's millis()
+  int64_t common_ms; // host time, or local_ms + skew
+} Stamp;
+
+typedef struct _SEvent
+{
+  std::string eid; // "-" for records logged without an id
+  Stamp stamp[STAGES];
+} Event;
+
+typedef struct _SOptions
+{
+  std::string db_path;
+  std::map<std::string, int64_t> skew;
+  bool events;
+  std::vector<std::pair<std::string, std::string>> logs; // device, path
+} Options;
+
+typedef struct _SCounts
+{
+  unsigned records;
+  unsigned duplicates;
+  unsigned unknown_stages;
+  unsigned anonymous_matched;
+  unsigned anonymous_unmatched;
+  unsigned negative_hops;
+} Counts;
+/*****************************************************************************/
+
+/**************************global variables***********************************/
+static const char *const stage_name[STAGES] = {"motion", "capture", "encode",
+                                               "upload_ack", "bt_rx", "lcd_drawn"};
+
+static std::vector<Event> events;            // events with an id, first seen first
+static std::map<std::string, size_t> event_index;
+static std::vector<Event> anonymous_events;  // "-" records, grouped per device
+static Counts counts;
+/*****************************************************************************/
+
+/***************user-defined functions****************************************/
+static void traceUsage(void)
+{
+  std::cerr << "usage: program [--db export.json] [--skew DEVICE=MS]... [--events] "
+               "[DEVICE=]file.log...\n";
+}
+
+static int traceStage(const std::string &name)
+{
+  for (int i = 0; i < STAGES; i++)
+  {
+    if (name == stage_name[i])
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// "camera=cam.log" -> camera, cam.log; "logs/uno.log" -> uno, logs/uno.log
+static std::pair<std::string, std::string> traceSplitDevice(const std::string &arg)
+{
+  std::string::size_type eq = arg.find('=');
+  if (eq != std::string::npos)
+  {
+    return std::make_pair(arg.substr(0, eq), arg.substr(eq + 1));
+  }
+  std::string::size_type slash = arg.find_last_of("/\\");
+  std::string base = (slash == std::string::npos) ? arg : arg.substr(slash + 1);
+  return std::make_pair(base.substr(0, base.find('.')), arg);
+}
+
+static bool traceParseArgs(int argc, char **argv, Options *options)
+{
+  options->events = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--db" && i + 1 < argc)
+    {
+      options->db_path = argv[++i];
+    }
+    else if (arg == "--skew" && i + 1 < argc)
+    {
+      std::pair<std::string, std::string> skew = traceSplitDevice(argv[++i]);
+      char *end;
+      long long ms = strtoll(skew.second.c_str(), &end, 10);
+      if (skew.first.empty() || skew.second.empty() || *end != '\0')
+      {
+        return false;
+      }
+      options->skew[skew.first] = ms;
+    }
+    else if (arg == "--events")
+    {
+      options->events = true;
+    }
+    else if (arg[0] != '-')
+    {
+      options->logs.push_back(traceSplitDevice(arg));
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return !options->logs.empty() || !options->db_path.empty();
+}
+
+static int64_t traceSkew(const Options &options, const std::string &device)
+{
+  std::map<std::string, int64_t>::const_iterator it = options.skew.find(device);
+  return (it == options.skew.end()) ? 0 : it->second;
+}
+
+static Event traceNewEvent(const std::string &eid)
+{
+  Event event;
+  event.eid = eid;
+  for (int i = 0; i < STAGES; i++)
+  {
+    event.stamp[i].is_set = false;
+  }
+  return event;
+}
+
+static int traceLastStage(const Event &event)
+{
+  for (int i = STAGES - 1; i >= 0; i--)
+  {
+    if (event.stamp[i].is_set)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int traceFirstStage(const Event &event)
+{
+  for (int i = 0; i < STAGES; i++)
+  {
+    if (event.stamp[i].is_set)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// an anonymous record continues the device's last anonymous event if it comes
+// after that event's last stage, otherwise it starts a new one
+static Event *traceAnonymousEvent(const std::string &device, int stage)
+{
+  for (std::vector<Event>::reverse_iterator it = anonymous_events.rbegin();
+       it != anonymous_events.rend(); ++it)
+  {
+    int last = traceLastStage(*it);
+    if (it->stamp[last].device != device)
+    {
+      continue;
+    }
+    if (last < stage)
+    {
+      return &*it;
+    }
+    break;
+  }
+  anonymous_events.push_back(traceNewEvent("-"));
+  return &anonymous_events.back();
+}
+
+static void traceAdd(const std::string &device, const std::string &eid, int stage,
+                     int64_t local_ms, int64_t common_ms)
+{
+  Event *event;
+  if (eid == "-")
+  {
+    event = traceAnonymousEvent(device, stage);
+  }
+  else
+  {
+    std::map<std::string, size_t>::iterator it = event_index.find(eid);
+    if (it == event_index.end())
+    {
+      event_index[eid] = events.size();
+      events.push_back(traceNewEvent(eid));
+      event = &events.back();
+    }
+    else
+    {
+      event = &events[it->second];
+    }
+  }
+
+  Stamp *stamp = &event->stamp[stage];
+  if (stamp->is_set) // e.g. in the camera's log and in the database
+  {
+    counts.duplicates++;
+    return;
+  }
+  stamp->is_set = true;
+  stamp->device = device;
+  stamp->local_ms = local_ms;
+  stamp->common_ms = common_ms;
+  counts.records++;
+}
+
+// "hh:mm:ss.mmm > " from the monitor's time filter, -1 if there is none
+static int64_t traceHostTime(const std::string &line, std::string::size_type *rest)
+{
+  unsigned hour, minute, second, milli;
+  int len = 0;
+  if (sscanf(line.c_str(), "%2u:%2u:%2u.%3u > %n", &hour, &minute, &second, &milli, &len) != 4 ||
+      len == 0)
+  {
+    *rest = 0;
+    return -1;
+  }
+  *rest = (std::string::size_type)len;
+  return (((int64_t)hour * 60 + minute) * 60 + second) * 1000 + milli;
+}
+
+static bool traceLoadLog(const Options &options, const std::string &device, const std::string &path)
+{
+  std::ifstream file(path.c_str());
+  if (!file)
+  {
+    std::cerr << "cannot open " << path << "\n";
+    return false;
+  }
+
+  int64_t skew = traceSkew(options, device);
+  std::string line;
+  while (std::getline(file, line))
+  {
+    std::string::size_type rest;
+    int64_t host_ms = traceHostTime(line, &rest);
+
+    std::istringstream fields(line.substr(rest));
+    std::string tag, eid, stage;
+    unsigned long long ms;
+    if (!(fields >> tag >> eid >> stage >> ms) || tag != "T")
+    {
+      continue; // not a trace record
+    }
+    int stage_id = traceStage(stage);
+    if (stage_id < 0)
+    {
+      counts.unknown_stages++;
+      continue;
+    }
+    traceAdd(device, eid, stage_id, (int64_t)ms, (host_ms >= 0) ? host_ms + skew : (int64_t)ms + skew);
+  }
+  return true;
+}
+
+/**************************database export************************************/
+// Walks a Realtime Database JSON export and picks the numbers at
+// .../evtdata/<eid>/<stage>. No tree is built, only the key path is kept.
+class JsonWalker
+{
+public:
+  JsonWalker(const std::string &text, const Options &options)
+      : pos(text.c_str()), end(text.c_str() + text.length()), options(options) {}
+
+  bool walk(void)
+  {
+    std::vector<std::string> path;
+    if (!value(&path))
+    {
+      return false;
+    }
+    skipSpace();
+    return pos == end;
+  }
+
+private:
+  const char *pos;
+  const char *end;
+  const Options &options;
+
+  void skipSpace(void)
+  {
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n'))
+    {
+      pos++;
+    }
+  }
+
+  bool readString(std::string *out)
+  {
+    if (pos >= end || *pos != '"')
+    {
+      return false;
+    }
+    for (pos++; pos < end; pos++)
+    {
+      if (*pos == '"')
+      {
+        pos++;
+        return true;
+      }
+      if (*pos == '\\' && ++pos == end)
+      {
+        break;
+      }
+      if (out != NULL)
+      {
+        out->push_back(*pos); // keys are plain ASCII, escapes are kept as is
+      }
+    }
+    return false;
+  }
+
+  bool number(const std::vector<std::string> &path)
+  {
+    char *stop;
+    double number = strtod(pos, &stop);
+    if (stop == pos)
+    {
+      return false;
+    }
+    pos = stop;
+
+    size_t depth = path.size();
+    if (depth >= 3 && path[depth - 3] == "evtdata")
+    {
+      int stage = traceStage(path[depth - 1]);
+      if (stage >= 0)
+      {
+        // the camera stores millis() as a signed int, undo the wrap
+        int64_t local_ms = (int64_t)(uint32_t)(int64_t)number;
+        traceAdd("camera", path[depth - 2], stage, local_ms, local_ms + traceSkew(options, "camera"));
+      }
+    }
+    return true;
+  }
+
+  bool literal(const char *word)
+  {
+    size_t len = strlen(word);
+    if ((size_t)(end - pos) < len || strncmp(pos, word, len) != 0)
+    {
+      return false;
+    }
+    pos += len;
+    return true;
+  }
+
+  bool value(std::vector<std::string> *path)
+  {
+    skipSpace();
+    if (pos >= end)
+    {
+      return false;
+    }
+    switch (*pos)
+    {
+    case '{':
+      pos++;
+      skipSpace();
+      if (pos < end && *pos == '}')
+      {
+        pos++;
+        return true;
+      }
+      for (;;)
+      {
+        std::string key;
+        skipSpace();
+        if (!readString(&key))
+        {
+          return false;
+        }
+        skipSpace();
+        if (pos >= end || *pos++ != ':')
+        {
+          return false;
+        }
+        path->push_back(key);
+        bool is_value = value(path);
+        path->pop_back();
+        if (!is_value)
+        {
+          return false;
+        }
+        skipSpace();
+        if (pos < end && *pos == ',')
+        {
+          pos++;
+          continue;
+        }
+        return pos < end && *pos++ == '}';
+      }
+    case '[':
+      pos++;
+      skipSpace();
+      if (pos < end && *pos == ']')
+      {
+        pos++;
+        return true;
+      }
+      for (;;)
+      {
+        path->push_back("");
+        bool is_value = value(path);
+        path->pop_back();
+        if (!is_value)
+        {
+          return false;
+        }
+        skipSpace();
+        if (pos < end && *pos == ',')
+        {
+          pos++;
+          continue;
+        }
+        return pos < end && *pos++ == ']';
+      }
+    case '"':
+      return readString(NULL);
+    case 't':
+      return literal("true");
+    case 'f':
+      return literal("false");
+    case 'n':
+      return literal("null");
+    default:
+      return number(*path);
+    }
+  }
+};
+/*****************************************************************************/
+
+static bool traceLoadDb(const Options &options)
+{
+  std::ifstream file(options.db_path.c_str(), std::ios::binary);
+  if (!file)
+  {
+    std::cerr << "cannot open " << options.db_path << "\n";
+    return false;
+  }
+  std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  JsonWalker walker(text, options);
+  if (!walker.walk())
+  {
+    std::cerr << options.db_path << ": not valid JSON\n";
+    return false;
+  }
+  return true;
+}
+
+// gives each anonymous event to the latest event with an id that ends
+// before it starts and has none of its stages yet
+static void traceMatchAnonymous(void)
+{
+  for (size_t i = 0; i < anonymous_events.size(); i++)
+  {
+    const Event &anonymous = anonymous_events[i];
+    int first = traceFirstStage(anonymous);
+    int64_t start_ms = anonymous.stamp[first].common_ms;
+
+    Event *best = NULL;
+    for (size_t j = 0; j < events.size(); j++)
+    {
+      int last = traceLastStage(events[j]);
+      if (last >= first || events[j].stamp[last].common_ms > start_ms)
+      {
+        continue;
+      }
+      if (best == NULL || events[j].stamp[last].common_ms > best->stamp[traceLastStage(*best)].common_ms)
+      {
+        best = &events[j];
+      }
+    }
+
+    if (best == NULL)
+    {
+      counts.anonymous_unmatched++;
+      continue;
+    }
+    for (int stage = first; stage < STAGES; stage++)
+    {
+      if (anonymous.stamp[stage].is_set)
+      {
+        best->stamp[stage] = anonymous.stamp[stage];
+      }
+    }
+    counts.anonymous_matched++;
+  }
+}
+
+// within one device its own clock, across devices the common one
+static int64_t traceHop(const Stamp &from, const Stamp &to)
+{
+  if (from.device == to.device)
+  {
+    return to.local_ms - from.local_ms;
+  }
+  return to.common_ms - from.common_ms;
+}
+
+static int64_t tracePercentile(std::vector<int64_t> values, double p)
+{
+  std::sort(values.begin(), values.end());
+  size_t idx = (size_t)(p * (values.size() - 1) + 0.5);
+  return values[idx];
+}
+
+static void tracePrintStats(const std::string &name, const std::vector<int64_t> &values)
+{
+  int64_t sum = 0;
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    sum += values[i];
+  }
+  printf("  %-24s %5zu %8lld %8lld %8lld %8lld %8lld %10.1f\n", name.c_str(), values.size(),
+         (long long)tracePercentile(values, 0.0), (long long)tracePercentile(values, 0.50),
+         (long long)tracePercentile(values, 0.90), (long long)tracePercentile(values, 0.99),
+         (long long)tracePercentile(values, 1.0), (double)sum / values.size());
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!traceParseArgs(argc, argv, &options))
+  {
+    traceUsage();
+    return 2;
+  }
+  if (!options.db_path.empty() && !traceLoadDb(options))
+  {
+    return 2;
+  }
+  for (size_t i = 0; i < options.logs.size(); i++)
+  {
+    if (!traceLoadLog(options, options.logs[i].first, options.logs[i].second))
+    {
+      return 2;
+    }
+  }
+  traceMatchAnonymous();
+
+  std::map<std::pair<int, int>, std::vector<int64_t>> hops;
+  std::vector<int64_t> end_to_end;
+  unsigned complete = 0;
+
+  if (options.events)
+  {
+    printf("event     ");
+    for (int i = 0; i < STAGES; i++)
+    {
+      printf(" %10s", stage_name[i]);
+    }
+    printf("   ms from the first stage\n");
+  }
+
+  for (size_t i = 0; i < events.size(); i++)
+  {
+    const Event &event = events[i];
+    int64_t at_ms[STAGES];
+    int prev = -1;
+    for (int stage = 0; stage < STAGES; stage++)
+    {
+      if (!event.stamp[stage].is_set)
+      {
+        continue;
+      }
+      if (prev < 0)
+      {
+        at_ms[stage] = 0;
+      }
+      else
+      {
+        int64_t hop_ms = traceHop(event.stamp[prev], event.stamp[stage]);
+        if (hop_ms < 0)
+        {
+          counts.negative_hops++;
+        }
+        hops[std::make_pair(prev, stage)].push_back(hop_ms);
+        at_ms[stage] = at_ms[prev] + hop_ms;
+      }
+      prev = stage;
+    }
+
+    if (event.stamp[STAGE_MOTION].is_set && event.stamp[STAGE_LCD_DRAWN].is_set)
+    {
+      end_to_end.push_back(at_ms[STAGE_LCD_DRAWN]);
+      complete++;
+    }
+
+    if (options.events)
+    {
+      printf("%-10s", event.eid.c_str());
+      for (int stage = 0; stage < STAGES; stage++)
+      {
+        if (event.stamp[stage].is_set)
+        {
+          printf(" %10lld", (long long)at_ms[stage]);
+        }
+        else
+        {
+          printf(" %10s", "-");
+        }
+      }
+      printf("\n");
+    }
+  }
+
+  if (options.events)
+  {
+    printf("\n");
+  }
+  printf("%zu events, %u complete (motion to lcd_drawn), %u records", events.size(), complete,
+         counts.records);
+  if (counts.duplicates)
+  {
+    printf(", %u duplicates ignored", counts.duplicates);
+  }
+  if (counts.unknown_stages)
+  {
+    printf(", %u unknown stages", counts.unknown_stages);
+  }
+  printf("\n");
+  if (counts.anonymous_matched || counts.anonymous_unmatched)
+  {
+    printf("records without an id: %u events matched by time, %u unmatched\n",
+           counts.anonymous_matched, counts.anonymous_unmatched);
+  }
+
+  if (hops.empty())
+  {
+    return 0;
+  }
+  printf("\nhop                          n      min      p50      p90      p99      max       mean  ms\n");
+  for (std::map<std::pair<int, int>, std::vector<int64_t>>::const_iterator it = hops.begin();
+       it != hops.end(); ++it)
+  {
+    tracePrintStats(std::string(stage_name[it->first.first]) + " -> " + stage_name[it->first.second],
+                    it->second);
+  }
+  if (!end_to_end.empty())
+  {
+    tracePrintStats("end to end", end_to_end);
+  }
+  if (counts.negative_hops)
+  {
+    printf("\n%u negative hops between devices, check --skew or the host time stamps\n",
+           counts.negative_hops);
+  }
+  return 0;
+}
+/*****************************************************************************/